@@ -0,0 +1,92 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+
+// Times AssemblerPassFixInstructions on single functions of 125K to 1M instructions, all of them
+// needing legalizing, and fails when the time per instruction grows with the function.
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/AssemblerPassFixInstructions.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+namespace {
+
+using namespace billiec::codegen;
+
+// Slots run past ldr/str's reach, so the far ones go through a stepped base.
+constexpr int stack_size = 64 * 1024;
+constexpr int repeats = 3;
+constexpr double max_growth = 2.0;
+
+MachineProgram make_program(std::size_t instruction_count) {
+    MachineFunction function;
+    function.name = "main";
+    function.callee_saved_registers = {Register::W19, Register::W20, Register::W21};
+    
+    MachineBlock block;
+    block.instructions.reserve(instruction_count + 1);
+    for(std::size_t idx = 0; idx < instruction_count; ++idx) {
+        auto slot = MachineOperand::stack(static_cast<int>((idx * 4) % stack_size));
+        auto other = MachineOperand::stack(static_cast<int>((idx * 12 + 4) % stack_size));
+        switch(idx % 4) {
+            case 0:
+                block.instructions.push_back(MachineInstruction::create(Opcode::mov, {slot, MachineOperand::imm(0x12345 + static_cast<int>(idx))}));
+                break;
+            case 1:
+                block.instructions.push_back(MachineInstruction::create(Opcode::mov, {slot, other}));
+                break;
+            case 2:
+                block.instructions.push_back(MachineInstruction::create(Opcode::add, {slot, other, MachineOperand::imm(70000)}));
+                break;
+            default:
+                block.instructions.push_back(MachineInstruction::create(Opcode::neg, {MachineOperand::reg(Register::W19), slot}));
+                break;
+        }
+    }
+    block.instructions.push_back(MachineInstruction::create(Opcode::ret));
+    function.blocks.push_back(std::move(block));
+    
+    MachineProgram program;
+    program.functions.push_back(std::move(function));
+    return program;
+}
+
+// Best of a few runs, the building of the input isn't timed.
+double time_per_instruction(std::size_t instruction_count) {
+    auto best = std::chrono::steady_clock::duration::max();
+    for(int run = 0; run < repeats; ++run) {
+        auto pass = AssemblerPassFixInstructions{make_program(instruction_count), stack_size};
+        auto start = std::chrono::steady_clock::now();
+        pass.process();
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    
+    auto nanoseconds = std::chrono::duration<double, std::nano>(best).count();
+    std::cout << "fix instructions " << instruction_count << ": "
+              << nanoseconds / 1e6 << " ms, " << nanoseconds / static_cast<double>(instruction_count) << " ns/instruction\n";
+    return nanoseconds / static_cast<double>(instruction_count);
+}
+
+} // namespace
+
+int main() {
+    constexpr std::array<std::size_t, 4> sizes = {125'000, 250'000, 500'000, 1'000'000};
+    double smallest = 0.0;
+    double largest = 0.0;
+    for(auto curr_size: sizes) {
+        auto per_instruction = time_per_instruction(curr_size);
+        smallest = curr_size == sizes.front() ? per_instruction : smallest;
+        largest = per_instruction;
+    }
+    
+    auto growth = largest / smallest;
+    std::cout << "fix instructions growth per instruction, " << sizes.front() << " to " << sizes.back() << ": " << growth << "x\n";
+    if (growth > max_growth) {
+        std::cout << "fix instructions doesn't scale linearly\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+
+// Times LivenessAnalysis, and the live ranges built from it, on functions of 25K to 200K
+// temporaries, and fails when the time per temporary grows with the function.
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/LivenessAnalysis.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace {
+
+using namespace billiec::codegen;
+
+// Every block falls through to the next, so the solver has edges to carry values across.
+constexpr std::size_t block_count = 16;
+constexpr int repeats = 3;
+constexpr double max_growth = 2.0;
+
+// Each temporary is defined once and read by the next one and by one far ahead of it, so many
+// ranges cross block boundaries.
+MachineFunction make_function(std::size_t temporary_count) {
+    MachineFunction function;
+    function.name = "main";
+    function.pseudo_registers.reserve(temporary_count);
+    for(std::size_t idx = 0; idx < temporary_count; ++idx) {
+        function.pseudo_registers.push_back(PseudoRegisterInfo{.name = "tmp." + std::to_string(idx)});
+    }
+    
+    auto per_block = (temporary_count + block_count - 1) / block_count;
+    function.blocks.resize(block_count);
+    for(std::size_t idx = 0; idx < temporary_count; ++idx) {
+        auto& instructions = function.blocks[idx / per_block].instructions;
+        auto dst = MachineOperand::pseudo(static_cast<int>(idx));
+        if (idx < 2) {
+            instructions.push_back(MachineInstruction::create(Opcode::mov, {dst, MachineOperand::imm(static_cast<int>(idx))}));
+            continue;
+        }
+        auto previous = MachineOperand::pseudo(static_cast<int>(idx - 1));
+        auto far = MachineOperand::pseudo(static_cast<int>(idx / 2));
+        instructions.push_back(MachineInstruction::create(Opcode::add, {dst, previous, far}));
+    }
+    function.blocks.back().instructions.push_back(MachineInstruction::create(Opcode::mov, {
+        MachineOperand::reg(Register::W0), MachineOperand::pseudo(static_cast<int>(temporary_count - 1))
+    }));
+    function.blocks.back().instructions.push_back(MachineInstruction::create(Opcode::ret));
+    return function;
+}
+
+// Best of a few runs, the building of the input isn't timed.
+double time_per_temporary(std::size_t temporary_count) {
+    auto function = make_function(temporary_count);
+    auto best = std::chrono::steady_clock::duration::max();
+    std::size_t live_ranges = 0;
+    for(int run = 0; run < repeats; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        LivenessAnalysis liveness{function};
+        liveness.process();
+        live_ranges = liveness.live_ranges().size();
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    
+    auto nanoseconds = std::chrono::duration<double, std::nano>(best).count();
+    std::cout << "liveness " << temporary_count << " temporaries, " << live_ranges << " ranges: "
+              << nanoseconds / 1e6 << " ms, " << nanoseconds / static_cast<double>(temporary_count) << " ns/temporary\n";
+    return nanoseconds / static_cast<double>(temporary_count);
+}
+
+} // namespace
+
+int main() {
+    constexpr std::array<std::size_t, 4> sizes = {25'000, 50'000, 100'000, 200'000};
+    double smallest = 0.0;
+    double largest = 0.0;
+    for(auto curr_size: sizes) {
+        auto per_temporary = time_per_temporary(curr_size);
+        smallest = curr_size == sizes.front() ? per_temporary : smallest;
+        largest = per_temporary;
+    }
+    
+    auto growth = largest / smallest;
+    std::cout << "liveness growth per temporary, " << sizes.front() << " to " << sizes.back() << ": " << growth << "x\n";
+    if (growth > max_growth) {
+        std::cout << "liveness doesn't scale linearly\n";
+        return 1;
+    }
+    return 0;
+}
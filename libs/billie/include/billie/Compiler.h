@@ -0,0 +1,60 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <core/Diagnostics.h>
+#include <scanner/PrecompiledHeader.h>
+#include <scanner/SourceFileCache.h>
+
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace billiec::billie {
+
+/** @brief  What a Compiler is set up with, the same for every compile it runs. */
+struct CompilerSettings {
+    std::vector<std::filesystem::path> include_directories;    ///< Searched by #include in the order given.
+    std::vector<std::pair<std::string, std::string>> defines;   ///< Macro names and bodies, as -D gives them.
+    std::shared_ptr<const scanner::PrecompiledHeader> precompiled_header;  ///< Every compile starts from it when set.
+};
+
+/** @brief  How one buffer is compiled. */
+struct CompileOptions {
+    std::string file_name{"<buffer>"};  ///< What diagnostics call the buffer, quoted includes are looked for next to it.
+    std::string mcpu{"generic"};
+    std::string optimization_level{"1"};    ///< As -O names it.
+    bool        emit_timestamp{false};
+};
+
+/** @brief  Compiles buffers to assembly in memory, for programs that embed the compiler.
+ *
+ * A context keeps every header its compiles include scanned in its file cache, so a service
+ * compiling many small sources against the same headers reads and scans each one once.  Contexts
+ * share nothing, so threads can each compile on their own; calling \c compile on one context from
+ * several threads is safe too, the file cache is all they share and it locks.
+ */
+class Compiler {
+public:
+    explicit Compiler(CompilerSettings settings = {});
+
+    /** @brief  The assembly for \c source, or every diagnostic found in it. */
+    std::expected<std::string, Diagnostics> compile(std::string_view source, const CompileOptions& options = {});
+
+    /** @brief  The headers read so far, and how often they were found there. */
+    const scanner::SourceFileCache& file_cache() const {
+        return *file_cache_;
+    }
+
+private:
+    CompilerSettings settings_;
+    std::unique_ptr<scanner::SourceFileCache> file_cache_;
+
+    std::expected<std::vector<scanner::Token>, Diagnostics> preprocess_(std::vector<scanner::Token> tokens,
+                                                                       const CompileOptions& options);
+};
+
+} // namespace billiec::billie
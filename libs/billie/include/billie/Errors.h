@@ -0,0 +1,17 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+#include <system_error>
+
+namespace billiec::billie {
+
+enum class errc {
+    billie_no_error = 0x00,
+    billie_unknown_mcpu,
+    billie_unknown_optimization_level,
+    billie_file_error
+};
+
+std::error_code make_error_code(errc err);
+const std::error_category& get_error_category();
+
+} // namespace billiec::billie
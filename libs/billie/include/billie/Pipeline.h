@@ -0,0 +1,47 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/AssemblerPassRegisterAllocator.h>
+#include <codegen/AssemblerPassScheduler.h>
+#include <codegen/MachineModel.h>
+#include <codegen/OptimizationLevel.h>
+#include <parser/Ast.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace billiec::billie {
+
+/** @brief  Runs one phase of the pipeline, \c phase is a string literal naming it.
+ *
+ * The driver hands in one that times and counts allocations per phase, without one each phase
+ * just runs.
+ */
+using PhaseRunner = std::function<void(const char* phase, const std::function<void()>& run)>;
+
+/** @brief  A program lowered all the way, ready to emit, and what the passes did on the way. */
+struct LoweredProgram {
+    codegen::MachineProgram program;
+    std::uint64_t instruction_count{0};     ///< Straight out of selection, before allocation adds any.
+    std::size_t redundant_values{0};        ///< Value numbering's, see TackyPassValueNumbering.
+    std::size_t folded_values{0};
+    std::map<std::string, codegen::RegisterAllocationStats> register_allocation_stats;
+    std::map<std::string, int> peephole_stats;
+    std::map<std::string, codegen::ScheduleStats> schedule_stats;
+};
+
+/** @brief  Runs every pass from TACKY generation to scheduling, the ones \c level leaves out skipped.
+ *
+ * The one pass sequence the driver, batch mode, the compile server and Compiler all go through, a
+ * new pass goes in here once.
+ */
+LoweredProgram lower_program(parser::ProgramNode::PtrType program,
+                             const codegen::OptimizationLevel& level,
+                             const codegen::MachineModel& machine_model,
+                             const PhaseRunner& run_phase = {});
+
+} // namespace billiec::billie
@@ -0,0 +1,115 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <billie/Compiler.h>
+
+#include <billie/Errors.h>
+#include <billie/Pipeline.h>
+
+#include <codegen/AssemblerPassEmit.h>
+#include <codegen/MachineModel.h>
+#include <codegen/OptimizationLevel.h>
+#include <parser/LanguageParser.h>
+#include <scanner/Preprocessor.h>
+#include <scanner/ScannerError.h>
+#include <scanner/TokenScanner.h>
+
+#include <sstream>
+
+namespace billiec::billie {
+
+namespace {
+
+Diagnostics single_diagnostic(const Diagnostic& diagnostic) {
+    Diagnostics diagnostics;
+    diagnostics.report(diagnostic);
+    return diagnostics;
+}
+
+} // namespace
+
+Compiler::Compiler(CompilerSettings settings):
+    settings_{std::move(settings)},
+    file_cache_{std::make_unique<scanner::SourceFileCache>()} {
+}
+
+std::expected<std::string, Diagnostics> Compiler::compile(std::string_view source, const CompileOptions& options) {
+    const auto* machine_model = codegen::find_machine_model(options.mcpu);
+    if (machine_model == nullptr) {
+        return std::unexpected{single_diagnostic(Diagnostic{
+            .code = make_error_code(errc::billie_unknown_mcpu),
+            .message = "Unknown -mcpu"
+        })};
+    }
+    const auto* optimization_level = codegen::find_optimization_level(options.optimization_level);
+    if (optimization_level == nullptr) {
+        return std::unexpected{single_diagnostic(Diagnostic{
+            .code = make_error_code(errc::billie_unknown_optimization_level),
+            .message = "Unknown optimization level"
+        })};
+    }
+
+    scanner::TokenScanner scanner{std::string{source}};
+    auto tokens = scanner.scan();
+    if (!tokens) {
+        return std::unexpected{std::move(tokens.error())};
+    }
+
+    // Sources without a single '#' and no macros of their own have nothing for the preprocessor to do.
+    if (!settings_.defines.empty() || settings_.precompiled_header || source.find('#') != std::string_view::npos) {
+        tokens = preprocess_(std::move(*tokens), options);
+        if (!tokens) {
+            return std::unexpected{std::move(tokens.error())};
+        }
+    }
+
+    parser::LanguageParser parser{std::move(*tokens)};
+    auto program_node = parser.parse();
+    if (!program_node) {
+        return std::unexpected{std::move(program_node.error())};
+    }
+
+    auto lowered = lower_program(std::move(*program_node), *optimization_level, *machine_model);
+
+    std::ostringstream stream;
+    auto emit = codegen::AssemblerPassEmit(lowered.program, stream);
+    emit.emit_timestamp = options.emit_timestamp;
+    emit.process();
+    return std::move(stream).str();
+}
+
+// The preprocessor still stops at its first problem, that one comes back as the only diagnostic.
+std::expected<std::vector<scanner::Token>, Diagnostics> Compiler::preprocess_(std::vector<scanner::Token> tokens,
+                                                                              const CompileOptions& options) {
+    std::filesystem::path file;
+    try {
+        file = std::filesystem::absolute(options.file_name);
+        scanner::Preprocessor preprocessor{*file_cache_, settings_.include_directories};
+        for(const auto& [name, body]: settings_.defines) {
+            preprocessor.define(name, body);
+        }
+
+        // A stale precompiled header still names its header, preprocessing that gives the same tokens.
+        if (const auto& precompiled_header = settings_.precompiled_header) {
+            if (precompiled_header->is_current(*file_cache_)) {
+                preprocessor.use_precompiled_header(precompiled_header);
+            } else {
+                preprocessor.include(precompiled_header->header());
+            }
+        }
+        return preprocessor.preprocess(tokens, file);
+    } catch (const scanner::ScannerError& error) {
+        // One in the buffer itself is printed against it, like the parser's.
+        auto diagnostic = error.diagnostic;
+        if (diagnostic.file == file.string()) {
+            diagnostic.file.clear();
+        }
+        return std::unexpected{single_diagnostic(diagnostic)};
+    } catch (const std::filesystem::filesystem_error& error) {
+        return std::unexpected{single_diagnostic(Diagnostic{
+            .code = make_error_code(errc::billie_file_error),
+            .message = "Can't resolve a file name",
+            .detail = error.what()
+        })};
+    }
+}
+
+} // namespace billiec::billie
@@ -0,0 +1,46 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <billie/Errors.h>
+
+namespace billiec::billie {
+
+/** @brief  The \c std:error_category for the library interface. */
+struct ErrorCategory: public std::error_category
+{
+    ErrorCategory(){ }
+    ~ErrorCategory(){ }
+
+    virtual const char* name() const noexcept
+    {
+        return "billiec.billie.ErrorCategory";
+    }
+
+    virtual std::string message(int err) const
+    {
+        auto ec = static_cast<errc>(err);
+        switch(ec)
+        {
+            case errc::billie_no_error:
+                return "billie_no_error";
+            case errc::billie_unknown_mcpu:
+                return "billie_unknown_mcpu";
+            case errc::billie_unknown_optimization_level:
+                return "billie_unknown_optimization_level";
+            case errc::billie_file_error:
+                return "billie_file_error";
+            default:
+                return "Unknown Error";
+        }
+    }
+};
+
+static const ErrorCategory  g_Category;  ///< Global category, only one per module.
+
+std::error_code make_error_code(errc err) {
+    return std::error_code{static_cast<int>(err), g_Category};
+}
+
+const std::error_category& get_error_category() {
+    return g_Category;
+}
+
+} // namespace billiec::billie
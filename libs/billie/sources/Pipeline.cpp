@@ -0,0 +1,78 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <billie/Pipeline.h>
+
+#include <codegen/AssemblyGenerator.h>
+#include <codegen/AssemblerPassFixInstructions.h>
+#include <codegen/AssemblerPassPeephole.h>
+#include <codegen/AssemblerPassPseudoRegister.h>
+#include <codegen/TackyGenerator.h>
+#include <codegen/TackyPassValueNumbering.h>
+
+#include <utility>
+
+namespace billiec::billie {
+
+LoweredProgram lower_program(parser::ProgramNode::PtrType program,
+                             const codegen::OptimizationLevel& level,
+                             const codegen::MachineModel& machine_model,
+                             const PhaseRunner& run_phase) {
+    auto phase = [&](const char* name, const std::function<void()>& run) {
+        if (run_phase) {
+            run_phase(name, run);
+        } else {
+            run();
+        }
+    };
+    LoweredProgram lowered;
+
+    codegen::TackyNode::PtrType tacky_node;
+    phase("tacky", [&] {
+        auto tacky_generator = codegen::TackyGenerator{std::move(program)};
+        tacky_node = tacky_generator.generate_tacky();
+    });
+
+    auto value_numbering_pass = codegen::TackyPassValueNumbering{std::move(tacky_node)};
+    if (level.value_numbering) {
+        phase("value numbering", [&] { value_numbering_pass.process(); });
+    }
+    lowered.redundant_values = value_numbering_pass.redundant;
+    lowered.folded_values = value_numbering_pass.folded;
+
+    codegen::MachineProgram machine_program;
+    phase("assembly generation", [&] {
+        auto assembly_generator = codegen::AssemblyGenerator{std::move(value_numbering_pass.program)};
+        machine_program = assembly_generator.generate_assembly();
+    });
+
+    for(const auto& curr_function: machine_program.functions) {
+        lowered.instruction_count += curr_function.instruction_count();
+    }
+
+    auto register_allocator_pass = codegen::AssemblerPassRegisterAllocator{std::move(machine_program)};
+    phase("register allocation", [&] { register_allocator_pass.process(); });
+    lowered.register_allocation_stats = std::move(register_allocator_pass.stats);
+
+    auto pseudo_register_pass = codegen::AssemblerPassPseudoRegister{std::move(register_allocator_pass.program)};
+    int stack_offset = 0;
+    phase("pseudo registers", [&] { stack_offset = pseudo_register_pass.process(); });
+
+    auto fix_instructions_pass = codegen::AssemblerPassFixInstructions{std::move(pseudo_register_pass.program), stack_offset};
+    phase("fix instructions", [&] { fix_instructions_pass.process(); });
+
+    auto peephole_pass = codegen::AssemblerPassPeephole{std::move(fix_instructions_pass.program)};
+    if (level.peephole) {
+        phase("peephole", [&] { peephole_pass.process(); });
+    }
+    lowered.peephole_stats = std::move(peephole_pass.stats);
+
+    auto scheduler_pass = codegen::AssemblerPassScheduler{std::move(peephole_pass.program), machine_model};
+    if (level.schedule) {
+        phase("schedule", [&] { scheduler_pass.process(); });
+    }
+    lowered.schedule_stats = std::move(scheduler_pass.stats);
+
+    lowered.program = std::move(scheduler_pass.program);
+    return lowered;
+}
+
+} // namespace billiec::billie
@@ -1,254 +1,230 @@
 // Copyright 2025 Yasser Zabuair.
 #pragma once
 
-#include <scanner/Token.h>
-
-#include <iostream>
-#include <memory>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace billiec::codegen {
 
-// Forwards
-struct CompoundAssemblerNode;
-struct ProgramAssemblerNode;
-struct FunctionAssemblerNode;
-struct MovInstructionNode;
-struct ReturnInstructionNode;
-struct LiteralInstructionNode;
-struct RegisterInstructionNode;
-struct UnaryInstructionNode;
-struct AllocateStack;
-struct PseudoRegister;
-
-
-// ---
-
-
-struct AssemblerNode {
-    using PtrType = std::unique_ptr<AssemblerNode>;
-    
-    AssemblerNode() = default;
-    virtual ~AssemblerNode() = default;
+// 32-bit views of the general purpose registers.  w29 (fp) and w30 (lr) are never handed out,
+// SP only ever shows up as the base of a stack slot.
+enum class Register: std::uint8_t {
+    W0 = 0, W1, W2, W3, W4, W5, W6, W7,
+    W8, W9, W10, W11, W12, W13, W14, W15,
+    W16, W17, W18, W19, W20, W21, W22, W23,
+    W24, W25, W26, W27, W28,
+    SP = 31
 };
 
-
 // ---
 
-struct CompoundAssemblerNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<CompoundAssemblerNode>;
-    std::vector<AssemblerNode::PtrType> instructions;
-    
-    CompoundAssemblerNode(std::vector<AssemblerNode::PtrType> instructions):
-        instructions{std::move(instructions)} {
-        
-    }
-    
-    static PtrType create(std::vector<AssemblerNode::PtrType> instructions) {
-        return std::make_unique<CompoundAssemblerNode>(std::move(instructions));
-    }
+enum class OperandKind: std::uint8_t {
+    none = 0,
+    reg,            ///< A physical register, \c value is the Register.
+    pseudo,         ///< A pseudo-register, \c value indexes the function's \c pseudo_registers.
+    stack,          ///< A stack slot at \c base + \c value.
+    imm             ///< An immediate.
 };
 
-// ---
-
-struct ProgramAssemblerNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<ProgramAssemblerNode>;
-    std::unique_ptr<AssemblerNode> function_definition;
-    
-    ProgramAssemblerNode(std::unique_ptr<AssemblerNode> function_definition):
-        function_definition{std::move(function_definition)} {
-    }
-    
-    static PtrType create(std::unique_ptr<AssemblerNode> function_definition) {
-        return std::make_unique<ProgramAssemblerNode>(std::move(function_definition));
-    }
+/** @brief  Which view of a register an operand names, values are all 32 bits but saving a
+ *          callee-saved register has to keep its upper half too.
+ */
+enum class RegisterWidth: std::uint8_t {
+    w = 0,
+    x
 };
 
-// ---
+/** @brief  One operand slot of a machine instruction, stored inline. */
+struct MachineOperand {
+    OperandKind kind{OperandKind::none};
+    Register base{Register::SP};    ///< Stack slots only, a scratch register holding the address of far slots.
+    RegisterWidth width{RegisterWidth::w};  ///< Registers only.
+    std::int32_t value{0};
 
-struct FunctionAssemblerNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<FunctionAssemblerNode>;
-    scanner::Token name;
-    std::vector<std::unique_ptr<AssemblerNode>> instructions;
-    
-    FunctionAssemblerNode(const scanner::Token& name,
-                 std::vector<std::unique_ptr<AssemblerNode>> instructions):
-        name{name},
-        instructions{std::move(instructions)} {
-        
+    static constexpr MachineOperand reg(Register which_register, RegisterWidth width = RegisterWidth::w) {
+        return {.kind = OperandKind::reg, .width = width, .value = static_cast<std::int32_t>(which_register)};
     }
-    
-    static PtrType create(const scanner::Token name,
-                   std::vector<std::unique_ptr<AssemblerNode>> instructions) {
-        return std::make_unique<FunctionAssemblerNode>(name, std::move(instructions));
-    }
-};
 
-// --
-
-struct MovInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<MovInstructionNode>;
-    std::unique_ptr<AssemblerNode> src;
-    std::unique_ptr<AssemblerNode> dst;
-    
-    MovInstructionNode(std::unique_ptr<AssemblerNode> src,
-                       std::unique_ptr<AssemblerNode> dst):
-        src{std::move(src)},
-        dst{std::move(dst)} {
-        
+    static constexpr MachineOperand pseudo(int pseudo_register) {
+        return {.kind = OperandKind::pseudo, .value = pseudo_register};
     }
-    
-    static PtrType create(std::unique_ptr<AssemblerNode> src,
-                          std::unique_ptr<AssemblerNode> dst) {
-        return std::make_unique<MovInstructionNode>(std::move(src), std::move(dst));
+
+    static constexpr MachineOperand stack(int offset, Register base = Register::SP) {
+        return {.kind = OperandKind::stack, .base = base, .value = offset};
     }
-};
 
-// --
+    static constexpr MachineOperand imm(int value) {
+        return {.kind = OperandKind::imm, .value = value};
+    }
 
-struct ReturnInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<ReturnInstructionNode>;
-    
-    ReturnInstructionNode() {
-        
+    constexpr bool is(OperandKind which) const {
+        return kind == which;
     }
-    
-    static PtrType create() {
-        return std::make_unique<ReturnInstructionNode>();
+
+    constexpr Register which_register() const {
+        return static_cast<Register>(value);
     }
+
+    constexpr bool operator==(const MachineOperand&) const = default;
 };
 
 // ---
 
-struct LiteralInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<LiteralInstructionNode>;
-    scanner::TokenValueType value;
-    
-    LiteralInstructionNode(const scanner::TokenValueType& value):
-        value{value} {
-        
-    }
-    
-    static PtrType create(const scanner::TokenValueType& value) {
-        return std::make_unique<LiteralInstructionNode>(value);
-    }
+enum class Opcode: std::uint8_t {
+    mov = 0,        ///< dst, src
+    movk,           ///< dst, imm; writes the 16-bit chunk at \c shift leaving the rest of dst alone.
+    neg,            ///< dst, src
+    mvn,            ///< dst, src
+    add,            ///< dst, lhs, rhs; rhs is shifted by \c shift the way \c shift_kind says first.
+    sub,            ///< dst, lhs, rhs; rhs is shifted by \c shift the way \c shift_kind says first.
+    lsl,            ///< dst, src; shifted by \c shift.
+    lsr,            ///< dst, src; shifted by \c shift.
+    asr,            ///< dst, src; shifted by \c shift.
+    mul,            ///< dst, lhs, rhs
+    smull,          ///< dst, lhs, rhs; the full 64-bit product shifted right by \c shift, at least 32.
+    sdiv,           ///< dst, lhs, rhs
+    madd,           ///< dst, lhs, rhs, addend; dst = addend + lhs * rhs.
+    msub,           ///< dst, lhs, rhs, addend; dst = addend - lhs * rhs.
+    ldr,            ///< dst, slot
+    str,            ///< src, slot
+    ldp,            ///< dst, dst, slot; two registers from consecutive slots their width apart.
+    stp,            ///< src, src, slot; two registers to consecutive slots their width apart.
+    stack_address,  ///< base, offset; points a scratch register at sp + offset for slots out of ldr/str's reach.
+    allocate_stack, ///< size
+    deallocate_stack, ///< size
+    ret,
+    count
 };
 
-// ---
+constexpr std::size_t opcode_count = static_cast<std::size_t>(Opcode::count);
+constexpr std::size_t max_operands = 4;
 
-struct RegisterInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<RegisterInstructionNode>;
-    
-    enum class Register {
-        W0 = 0
-    };
-    Register which_register;
-    
-    RegisterInstructionNode(Register which_register):
-        which_register{which_register} {
-    }
-    
-    static PtrType create(Register which_register) {
-        return std::make_unique<RegisterInstructionNode>(which_register);
-    }
+/** @brief  How an instruction uses one of its operand slots. */
+enum class OperandRole: std::uint8_t {
+    use = 1,
+    def = 2,
+    use_def = 3
 };
 
-// ---
+/** @brief  The layout of an opcode: its mnemonic and what each of its operand slots does. */
+struct OpcodeInfo {
+    const char* mnemonic;
+    std::uint8_t operand_count;
+    std::array<OperandRole, max_operands> roles;
+};
 
-struct UnaryInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<UnaryInstructionNode>;
-    
-    enum class Operator {
-        Neg = 0,
-        Not = 1
-    };
-    Operator unary_operator;
-    AssemblerNode::PtrType operand;
-    
-    UnaryInstructionNode(Operator unary_operator,
-                         AssemblerNode::PtrType operand):
-        unary_operator{unary_operator},
-        operand{std::move(operand)} {
-    }
-    
-    static PtrType create(Operator unary_operator,
-                          AssemblerNode::PtrType operand) {
-        return std::make_unique<UnaryInstructionNode>(unary_operator, std::move(operand));
-    }
+// Indexed by Opcode.
+inline constexpr auto opcode_info = [] {
+    using enum OperandRole;
+    return std::array<OpcodeInfo, opcode_count>{{
+        {"mov",   2, {def, use}},
+        {"movk",  2, {use_def, use}},
+        {"neg",   2, {def, use}},
+        {"mvn",   2, {def, use}},
+        {"add",   3, {def, use, use}},
+        {"sub",   3, {def, use, use}},
+        {"lsl",   2, {def, use}},
+        {"lsr",   2, {def, use}},
+        {"asr",   2, {def, use}},
+        {"mul",   3, {def, use, use}},
+        {"smull", 3, {def, use, use}},
+        {"sdiv",  3, {def, use, use}},
+        {"madd",  4, {def, use, use, use}},
+        {"msub",  4, {def, use, use, use}},
+        {"ldr",   2, {def, use}},
+        {"str",   2, {use, use}},
+        {"ldp",   3, {def, def, use}},
+        {"stp",   3, {use, use, use}},
+        {"add",   2, {def, use}},
+        {"sub",   1, {use}},
+        {"add",   1, {use}},
+        {"ret",   0, {}},
+    }};
+}();
+
+constexpr const OpcodeInfo& info_of(Opcode opcode) {
+    return opcode_info[static_cast<std::size_t>(opcode)];
+}
+
+/** @brief  How the last operand of an add or sub is shifted. */
+enum class ShiftKind: std::uint8_t {
+    lsl = 0,
+    lsr,
+    asr
 };
 
 // ---
 
-struct AllocateStackInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<AllocateStackInstructionNode>;
-    int size{0};
-    
-    AllocateStackInstructionNode(int size): size{size} {
-        
+/** @brief  A machine instruction, a fixed-size record with its operands inline. */
+struct MachineInstruction {
+    Opcode opcode{Opcode::ret};
+    std::uint8_t shift{0};
+    ShiftKind shift_kind{ShiftKind::lsl};
+    std::array<MachineOperand, max_operands> operands{};
+
+    static MachineInstruction create(Opcode opcode,
+                                     std::initializer_list<MachineOperand> operands = {},
+                                     int shift = 0,
+                                     ShiftKind shift_kind = ShiftKind::lsl) {
+        MachineInstruction ins;
+        ins.opcode = opcode;
+        ins.shift = static_cast<std::uint8_t>(shift);
+        ins.shift_kind = shift_kind;
+        std::size_t idx = 0;
+        for(const auto& curr_operand: operands) {
+            ins.operands[idx++] = curr_operand;
+        }
+        return ins;
     }
-    
-    static PtrType create(int size) {
-        return std::make_unique<AllocateStackInstructionNode>(size);
+
+    /** @brief  The slots the opcode actually has. */
+    std::span<MachineOperand> operand_slots() {
+        return {operands.data(), info_of(opcode).operand_count};
+    }
+
+    std::span<const MachineOperand> operand_slots() const {
+        return {operands.data(), info_of(opcode).operand_count};
     }
 };
 
 // ---
 
-struct DeAllocateStackInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<DeAllocateStackInstructionNode>;
-    int size{0};
-    
-    DeAllocateStackInstructionNode(int size): size{size} {
-        
-    }
-    
-    static PtrType create(int size) {
-        return std::make_unique<DeAllocateStackInstructionNode>(size);
-    }
+/** @brief  A basic block, straight-line instructions that only end in a return or fall through. */
+struct MachineBlock {
+    std::vector<MachineInstruction> instructions;
 };
 
 // ---
 
-struct PseudoRegister: public AssemblerNode {
-    using PtrType = std::unique_ptr<PseudoRegister>;
-    std::string identifier;
-    
-    PseudoRegister(const std::string& identifier): identifier{identifier} {
-    }
-    
-    static PtrType create(const std::string& identifier) {
-        return std::make_unique<PseudoRegister>(identifier);
-    }
+struct PseudoRegisterInfo {
+    std::string name;
+    int size{4};    ///< Width of the value in bytes, its stack slot is sized and aligned to match.
 };
 
-// ---
+struct MachineFunction {
+    std::string name;
+    std::vector<MachineBlock> blocks;
+    std::vector<PseudoRegisterInfo> pseudo_registers;       ///< What \c pseudo operands index.
+    std::vector<Register> callee_saved_registers;           ///< Filled in by register allocation.
 
-struct Stack: public AssemblerNode {
-    using PtrType = std::unique_ptr<Stack>;
-    int offset{0};
-    
-    Stack(int offset): offset{offset} {
-    }
-    
-    static PtrType create(int offset) {
-        return std::make_unique<Stack>(offset);
+    std::size_t instruction_count() const {
+        std::size_t count = 0;
+        for(const auto& curr_block: blocks) {
+            count += curr_block.instructions.size();
+        }
+        return count;
     }
 };
 
 // ---
 
-struct StoreInstructionNode: public AssemblerNode {
-    using PtrType = std::unique_ptr<StoreInstructionNode>;
-    int stack_offset;
-    
-    StoreInstructionNode(int offset): stack_offset{offset} {
-    }
-    
-    static PtrType create(int offset) {
-        return std::make_unique<StoreInstructionNode>(offset);
-    }
-    
+struct MachineProgram {
+    std::vector<MachineFunction> functions;
 };
 
-
 } // namespace billiec::codegen
@@ -0,0 +1,31 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+
+#include <cstdint>
+
+namespace billiec::codegen {
+
+/** @brief  Calls <tt>fn(operand, is_use, is_def)</tt> for every operand slot of an instruction. */
+template <typename Fn>
+void for_each_operand(MachineInstruction& ins, Fn&& fn) {
+    const auto& info = info_of(ins.opcode);
+    for(std::size_t idx = 0; idx < info.operand_count; ++idx) {
+        auto role = static_cast<std::uint8_t>(info.roles[idx]);
+        fn(ins.operands[idx],
+           (role & static_cast<std::uint8_t>(OperandRole::use)) != 0,
+           (role & static_cast<std::uint8_t>(OperandRole::def)) != 0);
+    }
+}
+
+/** @brief  Whether \c mov can encode the immediate as a single movz or movn. */
+inline bool fits_mov_immediate(int value) {
+    auto bits = static_cast<std::uint32_t>(value);
+    return (bits & 0xffff0000u) == 0 ||
+           (bits & 0x0000ffffu) == 0 ||
+           (~bits & 0xffff0000u) == 0 ||
+           (~bits & 0x0000ffffu) == 0;
+}
+
+} // namespace billiec::codegen
@@ -2,36 +2,31 @@
 #pragma once
 
 #include <codegen/AssemblerAst.h>
+#include <codegen/AssemblyBuffer.h>
 
 #include <iostream>
-#include <vector>
 
 namespace billiec::codegen {
+
+/** @brief  Prints the final instructions as assembly, formatted into a buffer and written out once. */
 struct AssemblerPassEmit {
-    std::vector<AssemblerNode::PtrType>& instructions;
+    const MachineProgram& program;
     std::ostream& ostream;
+    bool emit_timestamp{true};      ///< Off for output that has to be reproducible.
     
-    AssemblerPassEmit(std::vector<AssemblerNode::PtrType>& instructions,
+    AssemblerPassEmit(const MachineProgram& program,
                       std::ostream& ostream):
-        instructions{instructions},
+        program{program},
         ostream{ostream} {
     }
     void process();
     
 private:
-    void process_node_(AssemblerNode::PtrType& curr_node);
-    void visit_node_(CompoundAssemblerNode& node);
-    void visit_node_(ProgramAssemblerNode& node);
-    void visit_node_(FunctionAssemblerNode& node);
-    void visit_node_(MovInstructionNode& node);
-    void visit_node_(ReturnInstructionNode& node);
-    void visit_node_(LiteralInstructionNode& node);
-    void visit_node_(RegisterInstructionNode& node);
-    void visit_node_(UnaryInstructionNode& node);
-    void visit_node_(AllocateStackInstructionNode& node);
-    void visit_node_(DeAllocateStackInstructionNode& node);
-    void visit_node_(PseudoRegister& node);
-    void visit_node_(Stack& node);
+    AssemblyBuffer buffer_;
+    
+    void emit_function_(const MachineFunction& function);
+    void emit_instruction_(const MachineInstruction& ins, const MachineFunction& function);
+    void emit_operand_(const MachineOperand& operand, const MachineFunction& function);
 };
 
 } // namespace billiec::codegen
@@ -7,29 +7,44 @@
 
 namespace billiec::codegen {
 
+/** @brief  Turns what the earlier passes produced into instructions AArch64 can actually encode.
+ *
+ * Each function is walked once and rebuilt into a new list: operands on the stack become loads
+ * and stores through scratch registers, immediates and offsets that don't fit are split,
+ * and the prologue/epilogue go in as the walk reaches the start and each return.
+ */
 struct AssemblerPassFixInstructions {
-    std::vector<AssemblerNode::PtrType> instructions;
+    MachineProgram program;
     int stack_size{0};
-    FunctionAssemblerNode* curr_func{nullptr};
+    MachineFunction* curr_func{nullptr};
     
 public:
-    AssemblerPassFixInstructions(std::vector<AssemblerNode::PtrType> instructions,
+    AssemblerPassFixInstructions(MachineProgram program,
                                  int stack_size):
-        instructions{std::move(instructions)},
+        program{std::move(program)},
         stack_size{stack_size} {
     }
     
     void process();
     
 private:
-    void process_node_(AssemblerNode::PtrType& curr_node);
-    void visit_node_(CompoundAssemblerNode& node);
-    void visit_node_(ProgramAssemblerNode& node);
-    void visit_node_(FunctionAssemblerNode& node);
-    bool check_ret_node_(std::vector<AssemblerNode::PtrType>& instructions,
-                         std::vector<AssemblerNode::PtrType>::iterator itr);
-    void visit_node_(MovInstructionNode* node);
+    std::vector<MachineInstruction> fixed_;    ///< The current block's rebuilt instructions.
     
+    void fix_function_(MachineFunction& function);
+    void fix_instruction_(MachineInstruction ins);
+    void fix_mov_(MachineInstruction& ins);
+    void fix_operation_(MachineInstruction& ins);
+    MachineOperand source_(MachineOperand operand, Register scratch_source, bool allow_immediate);
+    void move_immediate_(int value, MachineOperand dst);
+    MachineOperand address_(MachineOperand slot, Register base);
+    void step_base_(Register base, int offset);
+    void emit_prologue_();
+    void emit_epilogue_();
+    void transfer_callee_saved_(Opcode single, Opcode pair);
+    void point_at_(Register base, int offset);
+    void adjust_stack_(int size, bool allocate);
+    int frame_size_(const MachineFunction& function) const;
+    int save_area_offset_() const;
 };
 
 } // namespace billiec::codegen
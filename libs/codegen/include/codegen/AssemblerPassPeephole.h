@@ -0,0 +1,32 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Last clean-up over the legal instruction stream before emission.
+ *
+ * Instructions are moved one at a time into a rebuilt list and the rules in the table are tried on
+ * its tail until none apply, so a rewrite can expose another one behind it.  How often each rule
+ * fired is kept in \c stats.
+ */
+struct AssemblerPassPeephole {
+    MachineProgram program;
+    std::map<std::string, int> stats;
+    
+    AssemblerPassPeephole(MachineProgram program):
+        program{std::move(program)} {
+    }
+    
+    void process();
+    
+private:
+    void optimize_block_(MachineBlock& block);
+};
+
+} // namespace billiec::codegen
@@ -1,29 +1,29 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
 
 #include <codegen/AssemblerAst.h>
 
-#include <iostream>
-#include <map>
 #include <vector>
 
 namespace billiec::codegen {
 
+/** @brief  Gives every pseudo-register left after register allocation a stack slot.
+ *
+ * Slots are colored by lifetime, pseudo-registers that are never live at the same time share
+ * one, so the frame grows with register pressure instead of with the number of temporaries.
+ */
 struct AssemblerPassPseudoRegister {
-    std::vector<AssemblerNode::PtrType> instructions;
-    std::vector<std::pair<std::string, int>> offsets;
+    MachineProgram program;
     
-    AssemblerPassPseudoRegister(std::vector<AssemblerNode::PtrType> instructions): instructions{std::move(instructions)} {
+    AssemblerPassPseudoRegister(MachineProgram program): program{std::move(program)} {
     }
     
     int process();
     
 private:
-    void process_node_(AssemblerNode::PtrType& curr_node);
-    void visit_node_(CompoundAssemblerNode& node);
-    void visit_node_(ProgramAssemblerNode& node);
-    void visit_node_(FunctionAssemblerNode& node);
-    void visit_node_(MovInstructionNode& node);
-    int get_offset_(const std::string& pseudo_register);
+    int stack_size_{0};
+    
+    int color_slots_(MachineFunction& function, std::vector<int>& slot_offsets);
 };
 
-} // namespace billie::codegen
+} // namespace billiec::codegen
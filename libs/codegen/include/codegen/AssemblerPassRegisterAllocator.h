@@ -0,0 +1,63 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace billiec::codegen {
+
+struct LivenessAnalysis;
+
+/** @brief  What the register allocator did to a single function. */
+struct RegisterAllocationStats {
+    int intervals{0};          ///< Pseudo-registers that needed a home.
+    int spills{0};             ///< Pseudo-registers left for the stack.
+    int rematerialized{0};     ///< Constants re-emitted at their uses instead of being spilled.
+    int callee_saved_used{0};  ///< Callee-saved registers that now need saving in the prologue.
+};
+
+/** @brief  Linear-scan allocation of pseudo-registers to physical registers.
+ *
+ * Caller-saved registers are handed out first since they cost nothing to use, callee-saved ones
+ * only when those run out.  Anything that still doesn't fit is left as a pseudo-register so
+ * AssemblerPassPseudoRegister gives it a stack slot, unless it just holds a literal in which case
+ * the literal is used directly.
+ */
+struct AssemblerPassRegisterAllocator {
+    MachineProgram program;
+    std::map<std::string, RegisterAllocationStats> stats;
+
+    AssemblerPassRegisterAllocator(MachineProgram program):
+        program{std::move(program)} {
+    }
+
+    void process();
+
+private:
+    struct Interval {
+        int pseudo_register{0};
+        int start{0};
+        int end{0};
+        int defs{0};
+        std::optional<int> constant;                ///< Literal moved in by the only def, if any.
+        int constant_def{-1};                       ///< Position of that def, so it can be dropped.
+        std::optional<Register> assigned;
+        bool spilled{false};
+    };
+
+    std::vector<Interval> intervals_;                  ///< Sorted by start once built.
+    std::vector<int> interval_idx_;                    ///< By pseudo-register.
+    std::vector<bool> dropped_;                        ///< By position.
+
+    void allocate_(MachineFunction& function);
+    void build_intervals_(const LivenessAnalysis& liveness);
+    void scan_(MachineFunction& function, RegisterAllocationStats& func_stats);
+    void rewrite_(const LivenessAnalysis& liveness);
+    void remove_dropped_(MachineFunction& function);
+};
+
+} // namespace billiec::codegen
@@ -0,0 +1,66 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/MachineModel.h>
+
+#include <map>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Estimated cycles of a function before and after scheduling, on the chosen model. */
+struct ScheduleStats {
+    int instructions{0};
+    int cycles_before{0};
+    int cycles_after{0};
+};
+
+/** @brief  List scheduler over the final instructions of each basic block.
+ *
+ * Builds the dependence graph of a block from the registers, sp, the scratch base and the stack
+ * slots each instruction touches, then issues instructions cycle by cycle in order of their
+ * critical path, as wide as the machine model allows and no more than it has pipes for.
+ * Anything it doesn't know how to reason about, returns included, stays where it is.
+ */
+struct AssemblerPassScheduler {
+    MachineProgram program;
+    const MachineModel& model;
+    std::map<std::string, ScheduleStats> stats;
+
+    AssemblerPassScheduler(MachineProgram program,
+                           const MachineModel& model):
+        program{std::move(program)},
+        model{model} {
+    }
+
+    void process();
+
+private:
+    struct Edge {
+        int to{0};
+        int latency{0};
+    };
+
+    struct Node {
+        PipelineClass pipeline{PipelineClass::integer_alu};
+        std::vector<Edge> successors;
+        int predecessors{0};
+        int height{0};
+    };
+
+    std::vector<Node> nodes_;
+
+    void schedule_block_(MachineBlock& block, ScheduleStats& func_stats);
+    void schedule_region_(std::span<const MachineInstruction> region,
+                          std::vector<MachineInstruction>& scheduled,
+                          ScheduleStats& func_stats);
+    void build_graph_(std::span<const MachineInstruction> region);
+    std::vector<int> list_schedule_();
+    int estimate_cycles_(const std::vector<int>& order) const;
+};
+
+} // namespace billiec::codegen
@@ -0,0 +1,80 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace billiec::codegen {
+
+/** @brief  Growable character buffer the emitter formats into, so the output goes out in one write.
+ *
+ * Appending text is a \c memcpy and integers go through \c std::to_chars, there is no locale,
+ * sentry or virtual call per token the way there is with a \c std::ostream.
+ */
+class AssemblyBuffer {
+public:
+    explicit AssemblyBuffer(std::size_t capacity = 4096) {
+        reserve(capacity);
+    }
+
+    AssemblyBuffer& operator<<(std::string_view text) {
+        std::memcpy(make_room_(text.size()), text.data(), text.size());
+        size_ += text.size();
+        return *this;
+    }
+
+    AssemblyBuffer& operator<<(char c) {
+        *make_room_(1) = c;
+        ++size_;
+        return *this;
+    }
+
+    AssemblyBuffer& operator<<(int value) {
+        // 11 characters covers "-2147483648".
+        char* begin = make_room_(11);
+        size_ += static_cast<std::size_t>(std::to_chars(begin, begin + 11, value).ptr - begin);
+        return *this;
+    }
+
+    void reserve(std::size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        auto grown = std::make_unique_for_overwrite<char[]>(capacity);
+        if (size_ != 0) {
+            std::memcpy(grown.get(), data_.get(), size_);
+        }
+        data_ = std::move(grown);
+        capacity_ = capacity;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+    std::string_view view() const {
+        return {data_.get(), size_};
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+private:
+    std::unique_ptr<char[]> data_;
+    std::size_t size_{0};
+    std::size_t capacity_{0};
+
+    char* make_room_(std::size_t count) {
+        if (size_ + count > capacity_) {
+            reserve(std::max(capacity_ * 2, size_ + count));
+        }
+        return data_.get() + size_;
+    }
+};
+
+} // namespace billiec::codegen
@@ -2,29 +2,32 @@
 #pragma once
 
 #include <codegen/AssemblerAst.h>
+#include <codegen/InstructionSelector.h>
 #include <codegen/TackyAst.h>
 #include <parser/Ast.h>
 
-#include <any>
-#include <map>
 #include <vector>
 
 namespace billiec::codegen {
 
 struct AssemblyGenerator: public TackyNodeVisitor {
     TackyNode::PtrType program_node;
-    std::vector<AssemblerNode::PtrType> instructions;
+    MachineProgram program;
     
     AssemblyGenerator(TackyNode::PtrType program_node): program_node{std::move(program_node)} {
     }
     
-    std::vector<std::unique_ptr<AssemblerNode>> generate_assembly();
-    std::unique_ptr<AssemblerNode> visit(const ProgramTackyNode& node) override;
-    std::unique_ptr<AssemblerNode> visit(const FunctionTackyNode& node) override;
-    std::unique_ptr<AssemblerNode> visit(const ReturnTackyNode& node) override;
-    std::unique_ptr<AssemblerNode> visit(const UnaryTackyNode& node) override;
-    std::unique_ptr<AssemblerNode> visit(const IntConstTackyNode& node) override;
-    std::unique_ptr<AssemblerNode> visit(const VarTackyNode& node) override;
+    MachineProgram generate_assembly();
+    void visit(const ProgramTackyNode& node) override;
+    void visit(const FunctionTackyNode& node) override;
+    void visit(const ReturnTackyNode&) override;
+    void visit(const UnaryTackyNode&) override;
+    void visit(const BinaryTackyNode&) override;
+    void visit(const IntConstTackyNode&) override;
+    void visit(const VarTackyNode&) override;
+    
+private:
+    InstructionSelector selector_;
 };
 
 
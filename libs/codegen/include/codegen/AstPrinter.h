@@ -21,8 +21,11 @@ public:
     std::string visit(const parser::FunctionNode& node) override;
     std::string visit(const parser::ReturnNode& node) override;
     std::string visit(const parser::UnaryNode& node) override;
+    std::string visit(const parser::BinaryNode& node) override;
     std::string visit(const parser::LiteralNode& node) override;
     
+private:
+    std::string print_expression_(const parser::AstNode& root);
 };
 
 } // namespace billiec::codegen
@@ -0,0 +1,104 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Fixed size dense bit set used for the dataflow analyses, one bit per tracked value. */
+class BitVector {
+private:
+    std::vector<std::uint64_t> words_;
+    std::size_t size_{0};
+
+public:
+    BitVector() = default;
+    BitVector(std::size_t size, bool value = false):
+        words_((size + 63) / 64, value ? ~std::uint64_t{0} : 0),
+        size_{size} {
+        clear_tail_();
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool test(std::size_t idx) const {
+        return (words_[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    void set(std::size_t idx) {
+        words_[idx / 64] |= std::uint64_t{1} << (idx % 64);
+    }
+
+    void reset(std::size_t idx) {
+        words_[idx / 64] &= ~(std::uint64_t{1} << (idx % 64));
+    }
+
+    void set_all() {
+        for(auto& curr_word: words_) {
+            curr_word = ~std::uint64_t{0};
+        }
+        clear_tail_();
+    }
+
+    std::size_t count() const {
+        std::size_t total = 0;
+        for(auto curr_word: words_) {
+            total += std::popcount(curr_word);
+        }
+        return total;
+    }
+
+    // The set operations report whether anything changed so the solver knows when to stop.
+    bool union_with(const BitVector& other) {
+        std::uint64_t changed = 0;
+        for(std::size_t idx = 0; idx < words_.size(); ++idx) {
+            auto merged = words_[idx] | other.words_[idx];
+            changed |= merged ^ words_[idx];
+            words_[idx] = merged;
+        }
+        return changed != 0;
+    }
+
+    bool intersect_with(const BitVector& other) {
+        std::uint64_t changed = 0;
+        for(std::size_t idx = 0; idx < words_.size(); ++idx) {
+            auto merged = words_[idx] & other.words_[idx];
+            changed |= merged ^ words_[idx];
+            words_[idx] = merged;
+        }
+        return changed != 0;
+    }
+
+    void subtract(const BitVector& other) {
+        for(std::size_t idx = 0; idx < words_.size(); ++idx) {
+            words_[idx] &= ~other.words_[idx];
+        }
+    }
+
+    /** @brief  Calls \c fn with the index of every set bit, lowest first. */
+    template <typename Fn>
+    void for_each_set(Fn&& fn) const {
+        for(std::size_t idx = 0; idx < words_.size(); ++idx) {
+            auto curr_word = words_[idx];
+            while(curr_word != 0) {
+                fn(idx * 64 + std::countr_zero(curr_word));
+                curr_word &= curr_word - 1;
+            }
+        }
+    }
+
+    bool operator==(const BitVector& other) const = default;
+
+private:
+    void clear_tail_() {
+        if (size_ % 64 != 0) {
+            words_.back() &= (std::uint64_t{1} << (size_ % 64)) - 1;
+        }
+    }
+};
+
+} // namespace billiec::codegen
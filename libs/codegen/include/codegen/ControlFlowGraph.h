@@ -0,0 +1,94 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  How control leaves an instruction, as far as building blocks is concerned. */
+enum class FlowKind {
+    fallthrough,
+    exit             ///< Returns, ends the block and has no successors.
+};
+
+/** @brief  A run of instructions [begin, end) in the function's linear instruction list. */
+struct BasicBlock {
+    int begin{0};
+    int end{0};
+    std::vector<int> successors{};
+    std::vector<int> predecessors{};
+};
+
+/** @brief  Basic blocks over a linear list of instructions.
+ *
+ * It only knows instruction positions, the caller says how each one transfers control, so the
+ * same graph works over the assembler instructions and over TACKY.
+ */
+struct ControlFlowGraph {
+    std::vector<BasicBlock> blocks;
+
+    template <typename Fn>
+    static ControlFlowGraph build(int instruction_count, Fn&& flow_of) {
+        ControlFlowGraph cfg;
+
+        int block_begin = 0;
+        for(int position = 0; position < instruction_count; ++position) {
+            auto flow = flow_of(position);
+            if (flow == FlowKind::exit || position + 1 == instruction_count) {
+                cfg.blocks.push_back(BasicBlock{.begin = block_begin, .end = position + 1});
+                block_begin = position + 1;
+            }
+        }
+
+        for(int idx = 0; idx + 1 < static_cast<int>(cfg.blocks.size()); ++idx) {
+            if (flow_of(cfg.blocks[idx].end - 1) == FlowKind::fallthrough) {
+                cfg.add_edge(idx, idx + 1);
+            }
+        }
+
+        return cfg;
+    }
+
+    void add_edge(int from, int to) {
+        blocks[from].successors.push_back(to);
+        blocks[to].predecessors.push_back(from);
+    }
+
+    /** @brief  Blocks in reverse post-order from the entry, unreachable blocks come last. */
+    std::vector<int> reverse_post_order() const {
+        std::vector<int> order;
+        std::vector<bool> visited(blocks.size(), false);
+
+        // Explicit stack of (block, next successor) so long chains of blocks can't blow the stack.
+        std::vector<std::pair<int, std::size_t>> stack;
+        if (!blocks.empty()) {
+            visited[0] = true;
+            stack.emplace_back(0, 0);
+        }
+        while(!stack.empty()) {
+            auto& [curr_block, next_succ] = stack.back();
+            if (next_succ < blocks[curr_block].successors.size()) {
+                int succ = blocks[curr_block].successors[next_succ++];
+                if (!visited[succ]) {
+                    visited[succ] = true;
+                    stack.emplace_back(succ, 0);
+                }
+            } else {
+                order.push_back(curr_block);
+                stack.pop_back();
+            }
+        }
+
+        std::reverse(std::begin(order), std::end(order));
+        for(int idx = 0; idx < static_cast<int>(blocks.size()); ++idx) {
+            if (!visited[idx]) {
+                order.push_back(idx);
+            }
+        }
+        return order;
+    }
+};
+
+} // namespace billiec::codegen
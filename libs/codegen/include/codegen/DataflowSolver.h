@@ -0,0 +1,142 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/BitVector.h>
+#include <codegen/ControlFlowGraph.h>
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace billiec::codegen {
+
+enum class DataflowDirection {
+    forward,
+    backward
+};
+
+enum class DataflowMeet {
+    union_of,        ///< "may" problems, e.g. liveness.
+    intersection_of  ///< "must" problems, e.g. available expressions.
+};
+
+/** @brief  Worklist solver for gen/kill bit-vector problems over a ControlFlowGraph.
+ *
+ * The client fills in \c gen and \c kill for every block, then \c solve() iterates
+ * <tt>out = gen | (in - kill)</tt> (in the direction of the problem) until nothing changes.
+ * Blocks are visited in reverse post-order for forward problems and post-order for backward
+ * ones, so acyclic code settles in a single pass.
+ */
+template <DataflowDirection Direction, DataflowMeet Meet>
+struct DataflowSolver {
+    const ControlFlowGraph& cfg;
+    std::size_t value_count{0};
+    std::vector<BitVector> gen;
+    std::vector<BitVector> kill;
+    std::vector<BitVector> in;     ///< Facts on entry to each block.
+    std::vector<BitVector> out;    ///< Facts on exit from each block.
+
+    DataflowSolver(const ControlFlowGraph& cfg, std::size_t value_count):
+        cfg{cfg},
+        value_count{value_count},
+        gen(cfg.blocks.size(), BitVector{value_count}),
+        kill(cfg.blocks.size(), BitVector{value_count}),
+        in(cfg.blocks.size(), BitVector{value_count}),
+        out(cfg.blocks.size(), BitVector{value_count}) {
+    }
+
+    void solve() {
+        auto order = cfg.reverse_post_order();
+        if constexpr (Direction == DataflowDirection::backward) {
+            std::reverse(std::begin(order), std::end(order));
+        }
+
+        // "Must" problems start from everything and shrink; the boundary blocks stay empty.
+        if constexpr (Meet == DataflowMeet::intersection_of) {
+            for(std::size_t idx = 0; idx < cfg.blocks.size(); ++idx) {
+                if (!boundary_(idx)) {
+                    meet_side_(idx).set_all();
+                }
+                transfer_(idx);
+            }
+        }
+
+        std::deque<int> worklist{std::begin(order), std::end(order)};
+        std::vector<bool> queued(cfg.blocks.size(), true);
+        while(!worklist.empty()) {
+            int curr_block = worklist.front();
+            worklist.pop_front();
+            queued[curr_block] = false;
+
+            meet_(curr_block);
+            if (!transfer_(curr_block)) {
+                continue;
+            }
+
+            for(int dependent: dependents_(curr_block)) {
+                if (!queued[dependent]) {
+                    queued[dependent] = true;
+                    worklist.push_back(dependent);
+                }
+            }
+        }
+    }
+
+private:
+    // The side of the block that the meet writes into, and the side the transfer produces.
+    BitVector& meet_side_(std::size_t block) {
+        return Direction == DataflowDirection::forward ? in[block] : out[block];
+    }
+
+    BitVector& transfer_side_(std::size_t block) {
+        return Direction == DataflowDirection::forward ? out[block] : in[block];
+    }
+
+    const std::vector<int>& sources_(std::size_t block) const {
+        return Direction == DataflowDirection::forward ? cfg.blocks[block].predecessors : cfg.blocks[block].successors;
+    }
+
+    const std::vector<int>& dependents_(std::size_t block) const {
+        return Direction == DataflowDirection::forward ? cfg.blocks[block].successors : cfg.blocks[block].predecessors;
+    }
+
+    bool boundary_(std::size_t block) const {
+        return sources_(block).empty();
+    }
+
+    void meet_(std::size_t block) {
+        const auto& sources = sources_(block);
+        if (sources.empty()) {
+            return;
+        }
+
+        auto& merged = meet_side_(block);
+        merged = transfer_side_(sources.front());
+        for(std::size_t idx = 1; idx < sources.size(); ++idx) {
+            if constexpr (Meet == DataflowMeet::union_of) {
+                merged.union_with(transfer_side_(sources[idx]));
+            } else {
+                merged.intersect_with(transfer_side_(sources[idx]));
+            }
+        }
+    }
+
+    // Returns true when the block's result changed.
+    bool transfer_(std::size_t block) {
+        scratch_ = meet_side_(block);
+        scratch_.subtract(kill[block]);
+        scratch_.union_with(gen[block]);
+
+        auto& current = transfer_side_(block);
+        if (scratch_ == current) {
+            return false;
+        }
+        std::swap(current, scratch_);
+        return true;
+    }
+
+    BitVector scratch_;
+};
+
+} // namespace billiec::codegen
@@ -0,0 +1,126 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/TackyAst.h>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Operators of the expression trees instruction selection works on. */
+enum class SelectionOperator {
+    Const = 0,
+    Var,
+    Neg,
+    Not,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Ret,
+    count
+};
+
+/** @brief  What a subtree can be reduced to. */
+enum class Nonterminal {
+    stmt = 0,   ///< Nothing left over, what the roots reduce to.
+    reg,        ///< A value in a register.
+    con,        ///< A constant known at compile time.
+    imm12,      ///< A constant add and sub take as an immediate.
+    nimm12,     ///< A constant whose negation is an imm12.
+    pow2,       ///< A power of two, used as a shift.
+    zero,
+    one,
+    minus_one,
+    pow2_plus1,     ///< Multiplied by with an add of the value shifted.
+    pow2_minus1,    ///< Multiplied by with a shift and a subtract.
+    npow2,          ///< A negated power of two, a divisor that's a shift and a negate.
+    divisor,        ///< Any other divisor a multiply by its magic number can stand in for.
+    count
+};
+
+/** @brief  How signed division by a constant becomes a multiply, from Hacker's Delight 10-1.
+ *
+ * n / d is the top half of n * multiplier shifted right by shift, with n added when d is positive
+ * and the multiplier came out negative, or subtracted in the opposite case, then rounded toward zero
+ * by adding its sign bit.
+ */
+struct DivisionMagic {
+    int multiplier{0};
+    int shift{0};
+};
+
+/** @brief  The magic numbers for \c divisor, anything but 0, 1, -1 and INT_MIN. */
+DivisionMagic signed_division_magic(int divisor);
+
+constexpr std::size_t selection_operator_count = static_cast<std::size_t>(SelectionOperator::count);
+constexpr std::size_t nonterminal_count = static_cast<std::size_t>(Nonterminal::count);
+
+/** @brief  Bottom-up rewrite instruction selection from the TACKY of a function.
+ *
+ * Temporaries that are written once and read once are folded back into their reader, so the
+ * function becomes a forest of expression trees.  Every node is labeled bottom up with the
+ * cheapest rule for each nonterminal from a rule table indexed at compile time, then the roots
+ * are reduced top down.  Patterns covering several TACKY operations at once, \c madd, shifted
+ * operands and immediates, win wherever they are cheaper than one instruction per operation, and
+ * multiplies and divides by constants become shifts and multiplies wherever those are cheaper.
+ */
+struct InstructionSelector {
+    MachineFunction function;
+
+    /** @brief  Selects a whole function body into a fresh \c function. */
+    void select(const std::vector<TackyNode::PtrType>& tacky_instructions);
+
+private:
+    struct Node {
+        SelectionOperator op{SelectionOperator::Const};
+        std::array<int, 2> kids{-1, -1};
+        int value{0};               ///< For constants, including the ones folded from constants.
+        std::string name;           ///< The variable read, or the temporary the result goes to.
+        bool stable{true};          ///< Reads nothing that's written more than once.
+        std::array<int, nonterminal_count> cost{};
+        std::array<int, nonterminal_count> rule{};
+    };
+
+    struct Binding {
+        int node{0};
+        Nonterminal nonterminal{Nonterminal::reg};
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<int> roots_;
+    std::unordered_map<std::string, int> uses_;
+    std::unordered_map<std::string, int> defs_;
+    std::unordered_map<std::string, int> pending_;    ///< Single-use results waiting for their reader.
+    std::unordered_map<std::string, int> pseudo_idx_; ///< Into function.pseudo_registers.
+    int temp_count_{0};
+
+    void reset_();
+    void count_operands_(const TackyNode& tacky_instruction);
+    void add_instruction_(const TackyNode& tacky_instruction);
+    int add_operand_(const TackyNode& operand);
+    int add_node_(SelectionOperator op, std::array<int, 2> kids, std::string name);
+    void define_(int node, const std::string& dst);
+    void label_(int node);
+    int match_(int node, int rule, std::size_t& pos) const;
+    void bind_(int node, int rule, std::size_t& pos, std::vector<Binding>& bindings) const;
+    int fold_(const Node& node) const;
+    void reduce_roots_();
+    MachineOperand reduce_(int node, Nonterminal nonterminal, const MachineOperand* dst);
+    std::optional<MachineOperand> reduce_leaf_(int node, int rule_idx, const MachineOperand* dst);
+    MachineOperand emit_rule_(int node, int rule_idx, const std::array<MachineOperand, 3>& leaves,
+                              const MachineOperand* dst);
+    void emit_quotient_(MachineOperand dividend, int divisor, MachineOperand target);
+    MachineOperand destination_(int node, const MachineOperand* dst);
+    MachineOperand pseudo_(const std::string& name);
+    void emit_(const MachineInstruction& ins);
+    std::string generate_temp_name_();
+};
+
+} // namespace billiec::codegen
@@ -0,0 +1,62 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/AssemblerAst.h>
+#include <codegen/BitVector.h>
+#include <codegen/ControlFlowGraph.h>
+
+#include <span>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Positions a pseudo-register is live over, \c end is one past the block end when it is live out. */
+struct LiveRange {
+    int start{0};
+    int end{0};
+};
+
+/** @brief  Which pseudo-registers are live on entry to and exit from every block of a function.
+ *
+ * Pseudo-registers are already numbered densely by the function, so the sets are bit vectors
+ * over those numbers.  Instructions are numbered by position across the blocks in order, and the
+ * defs/uses of every position are kept for the clients walking blocks afterwards.
+ */
+struct LivenessAnalysis {
+    MachineFunction& function;
+    ControlFlowGraph cfg;
+    std::vector<MachineInstruction*> instructions;     ///< By position.
+    std::vector<BitVector> live_in;
+    std::vector<BitVector> live_out;
+
+    LivenessAnalysis(MachineFunction& function):
+        function{function} {
+    }
+
+    void process();
+    
+    /** @brief  The range of every pseudo-register, indexed like the function's \c pseudo_registers.
+     *
+     * Pseudo-registers no instruction mentions any more come back with \c end of -1.
+     */
+    std::vector<LiveRange> live_ranges() const;
+
+    std::span<const int> uses(int position) const {
+        return {uses_.data() + use_begin_[position], uses_.data() + use_begin_[position + 1]};
+    }
+
+    std::span<const int> defs(int position) const {
+        return {defs_.data() + def_begin_[position], defs_.data() + def_begin_[position + 1]};
+    }
+
+private:
+    // Flattened per-instruction lists, instruction i owns [begin[i], begin[i+1]).
+    std::vector<int> use_begin_;
+    std::vector<int> uses_;
+    std::vector<int> def_begin_;
+    std::vector<int> defs_;
+
+    void number_operands_();
+};
+
+} // namespace billiec::codegen
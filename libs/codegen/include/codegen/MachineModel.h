@@ -0,0 +1,71 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace billiec::codegen {
+
+/** @brief  The kinds of pipeline an instruction issues to. */
+enum class PipelineClass {
+    integer_alu = 0,
+    integer_multiply,
+    integer_divide,
+    load,
+    store,
+    count
+};
+
+constexpr std::size_t pipeline_class_count = static_cast<std::size_t>(PipelineClass::count);
+
+/** @brief  What the scheduler knows about a core: how many instructions it issues a cycle,
+ *          how many pipes of each class it has and how long results take to come out of them.
+ */
+struct MachineModel {
+    std::string_view name;
+    int issue_width{1};
+    std::array<int, pipeline_class_count> latency{};
+    std::array<int, pipeline_class_count> units{};
+
+    constexpr int latency_of(PipelineClass pipeline) const {
+        return latency[static_cast<std::size_t>(pipeline)];
+    }
+
+    constexpr int units_of(PipelineClass pipeline) const {
+        return units[static_cast<std::size_t>(pipeline)];
+    }
+};
+
+// Numbers are for 32-bit operations.      alu mul div ld st
+inline constexpr MachineModel generic_model{
+    "generic", 2,        {1, 3, 12, 4, 1}, {2, 1, 1, 1, 1}
+};
+
+// Arm Neoverse N1 software optimization guide: 3 integer pipes (one doing multiply/divide),
+// 2 load/store pipes, 4-wide decode.
+inline constexpr MachineModel neoverse_n1_model{
+    "neoverse-n1", 4,    {1, 2, 12, 4, 1}, {3, 1, 1, 2, 2}
+};
+
+// Apple M1-class performance cores: 8-wide, 6 integer pipes (2 multiply, 1 divide),
+// 3 load and 2 store pipes.
+inline constexpr MachineModel apple_m1_model{
+    "apple-m1", 8,       {1, 3, 10, 4, 1}, {6, 2, 1, 3, 2}
+};
+
+inline constexpr std::array<const MachineModel*, 3> machine_models = {
+    &generic_model, &neoverse_n1_model, &apple_m1_model
+};
+
+/** @brief  The model for an \c -mcpu= name, or nullptr when there isn't one. */
+constexpr const MachineModel* find_machine_model(std::string_view name) {
+    for(auto curr_model: machine_models) {
+        if (curr_model->name == name) {
+            return curr_model;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace billiec::codegen
@@ -0,0 +1,40 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <array>
+#include <string_view>
+
+namespace billiec::codegen {
+
+/** @brief  Which of the optional passes an \c -O level runs.
+ *
+ * Everything else runs at every level, selection included, so even \c -O0 picks shifts over
+ * multiplies by constants.  Passes that trade compile time for code, an inliner and its budget
+ * among them, get their switch here.
+ */
+struct OptimizationLevel {
+    std::string_view name;
+    bool value_numbering{false};
+    bool peephole{false};
+    bool schedule{false};
+};
+
+//                                          vn     peep   sched
+inline constexpr OptimizationLevel o0_level{"0",  false, false, false};
+inline constexpr OptimizationLevel o1_level{"1",  true,  true,  true};
+
+inline constexpr std::array<const OptimizationLevel*, 2> optimization_levels = {
+    &o0_level, &o1_level
+};
+
+/** @brief  The level for an \c -O name, or nullptr when there isn't one. */
+constexpr const OptimizationLevel* find_optimization_level(std::string_view name) {
+    for(auto curr_level: optimization_levels) {
+        if (curr_level->name == name) {
+            return curr_level;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace billiec::codegen
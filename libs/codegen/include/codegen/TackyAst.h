@@ -1,7 +1,6 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #pragma once
 
-#include <codegen/AssemblerAst.h>
 #include <scanner/Token.h>
 
 #include <iostream>
@@ -15,6 +14,7 @@ struct ProgramTackyNode;
 struct FunctionTackyNode;
 struct ReturnTackyNode;
 struct UnaryTackyNode;
+struct BinaryTackyNode;
 struct IntConstTackyNode;
 struct VarTackyNode;
 
@@ -24,12 +24,13 @@ struct TackyNodeVisitor {
     TackyNodeVisitor() = default;
     virtual ~TackyNodeVisitor() = default;
     
-    virtual std::unique_ptr<AssemblerNode> visit(const ProgramTackyNode& node) = 0;
-    virtual std::unique_ptr<AssemblerNode> visit(const FunctionTackyNode& node) = 0;
-    virtual std::unique_ptr<AssemblerNode> visit(const ReturnTackyNode& node) = 0;
-    virtual std::unique_ptr<AssemblerNode> visit(const UnaryTackyNode& node) = 0;
-    virtual std::unique_ptr<AssemblerNode> visit(const IntConstTackyNode& node) = 0;
-    virtual std::unique_ptr<AssemblerNode> visit(const VarTackyNode& node) = 0;
+    virtual void visit(const ProgramTackyNode& node) = 0;
+    virtual void visit(const FunctionTackyNode& node) = 0;
+    virtual void visit(const ReturnTackyNode& node) = 0;
+    virtual void visit(const UnaryTackyNode& node) = 0;
+    virtual void visit(const BinaryTackyNode& node) = 0;
+    virtual void visit(const IntConstTackyNode& node) = 0;
+    virtual void visit(const VarTackyNode& node) = 0;
 };
 
 
@@ -39,7 +40,7 @@ struct TackyNode {
     TackyNode() = default;
     virtual ~TackyNode() = default;
     
-    virtual std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) = 0;
+    virtual void accept(TackyNodeVisitor& visitor) = 0;
 };
 
 // ---
@@ -56,8 +57,8 @@ struct ProgramTackyNode: public TackyNode {
         return std::make_unique<ProgramTackyNode>(std::move(function_definition));
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -79,8 +80,8 @@ struct FunctionTackyNode: public TackyNode {
         return std::make_unique<FunctionTackyNode>(name, std::move(instructions));
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -98,8 +99,8 @@ struct ReturnTackyNode: public TackyNode {
         return std::make_unique<ReturnTackyNode>(std::move(return_expr));
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -125,8 +126,39 @@ struct UnaryTackyNode: public TackyNode {
         return std::make_unique<UnaryTackyNode>(operation, std::move(src), std::move(dst));
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
+    }
+};
+
+// ---
+
+struct BinaryTackyNode: public TackyNode {
+    using PtrType = std::unique_ptr<BinaryTackyNode>;
+    scanner::Token operation;
+    std::unique_ptr<TackyNode> src1;
+    std::unique_ptr<TackyNode> src2;
+    std::unique_ptr<TackyNode> dst;
+    
+    BinaryTackyNode(const scanner::Token& operation,
+                    std::unique_ptr<TackyNode> src1,
+                    std::unique_ptr<TackyNode> src2,
+                    std::unique_ptr<TackyNode> dst):
+        operation{operation},
+        src1{std::move(src1)},
+        src2{std::move(src2)},
+        dst{std::move(dst)} {
+    }
+    
+    static PtrType create(const scanner::Token& operation,
+                          std::unique_ptr<TackyNode> src1,
+                          std::unique_ptr<TackyNode> src2,
+                          std::unique_ptr<TackyNode> dst) {
+        return std::make_unique<BinaryTackyNode>(operation, std::move(src1), std::move(src2), std::move(dst));
+    }
+    
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -143,8 +175,8 @@ struct IntConstTackyNode: public TackyNode {
         return std::make_unique<IntConstTackyNode>(value);
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -161,8 +193,8 @@ struct VarTackyNode: public TackyNode {
         return std::make_unique<VarTackyNode>(var_name);
     }
     
-    std::unique_ptr<AssemblerNode> accept(TackyNodeVisitor& visitor) override {
-        return visitor.visit(*this);
+    void accept(TackyNodeVisitor& visitor) override {
+        visitor.visit(*this);
     }
 };
 
@@ -14,6 +14,7 @@ namespace billiec::codegen {
 class TackyGenerator: public parser::AstNodeVisitor<TackyNode::PtrType> {
     parser::AstNode::PtrType program_node_;
     int curr_tmp_num_{0};
+    std::vector<TackyNode::PtrType> curr_instructions_;
     
 public:
     TackyGenerator(parser::AstNode::PtrType program_node):
@@ -29,26 +30,28 @@ public:
     }
     
     TackyNode::PtrType visit(const parser::FunctionNode& node) override {
-        std::vector<TackyNode::PtrType> instructions;
+        curr_instructions_.clear();
         for(const auto& curr_node: node.body) {
-            instructions.push_back(parser::accept(*this, curr_node));
+            // Expressions inside the statement append their own instructions first.
+            auto stmt = parser::accept(*this, curr_node);
+            curr_instructions_.push_back(std::move(stmt));
         }
         
-        return FunctionTackyNode::create(node.name, std::move(instructions));
+        return FunctionTackyNode::create(node.name, std::move(curr_instructions_));
     }
     
     TackyNode::PtrType visit(const parser::ReturnNode& node) override {
         return ReturnTackyNode::create(parser::accept(*this, node.return_expr));
     }
     
+    // Emits the expression's instructions into the current function and hands back what holds
+    // its result, so nested expressions come out as a flat list of instructions.
     TackyNode::PtrType visit(const parser::UnaryNode& node) override {
-        using namespace std::string_literals;
-        std::vector<TackyNode::PtrType> instructions;
-        
-        auto src = parser::accept(*this, node.expr);
-        auto dst_name = generate_temp_name_();
-        auto dst = VarTackyNode::create(dst_name);
-        return UnaryTackyNode::create(node.operation, std::move(src), std::move(dst));
+        return flatten_expression_(node);
+    }
+    
+    TackyNode::PtrType visit(const parser::BinaryNode& node) override {
+        return flatten_expression_(node);
     }
     
     TackyNode::PtrType visit(const parser::LiteralNode& node) override {
@@ -57,6 +60,65 @@ public:
     
 private:
     
+    /** @brief  Post-order walk over an expression from a worklist, operands before their operator.
+     *
+     * Each operator node is seen twice, once to queue its operands and once more, after their
+     * values are on \c values, to emit its own instruction.
+     */
+    TackyNode::PtrType flatten_expression_(const parser::AstNode& root) {
+        struct Step {
+            const parser::AstNode* node;
+            bool operands_done;
+        };
+        std::vector<Step> work{{&root, false}};
+        std::vector<TackyNode::PtrType> values;
+        
+        auto pop_value = [&values] {
+            auto value = std::move(values.back());
+            values.pop_back();
+            return value;
+        };
+        
+        while(!work.empty()) {
+            auto [node, operands_done] = work.back();
+            work.pop_back();
+            
+            if (auto unary = dynamic_cast<const parser::UnaryNode*>(node)) {
+                if (!operands_done) {
+                    work.push_back({node, true});
+                    work.push_back({unary->expr.get(), false});
+                    continue;
+                }
+                auto src = pop_value();
+                auto dst_name = generate_temp_name_();
+                curr_instructions_.push_back(UnaryTackyNode::create(unary->operation,
+                                                                    std::move(src),
+                                                                    VarTackyNode::create(dst_name)));
+                values.push_back(VarTackyNode::create(dst_name));
+            } else if (auto binary = dynamic_cast<const parser::BinaryNode*>(node)) {
+                if (!operands_done) {
+                    // The left side is popped, and so evaluated, first.
+                    work.push_back({node, true});
+                    work.push_back({binary->right.get(), false});
+                    work.push_back({binary->left.get(), false});
+                    continue;
+                }
+                auto src2 = pop_value();
+                auto src1 = pop_value();
+                auto dst_name = generate_temp_name_();
+                curr_instructions_.push_back(BinaryTackyNode::create(binary->operation,
+                                                                     std::move(src1),
+                                                                     std::move(src2),
+                                                                     VarTackyNode::create(dst_name)));
+                values.push_back(VarTackyNode::create(dst_name));
+            } else {
+                values.push_back(visit(dynamic_cast<const parser::LiteralNode&>(*node)));
+            }
+        }
+        
+        return pop_value();
+    }
+    
     std::string generate_temp_name_() {
         std::stringstream stream;
         
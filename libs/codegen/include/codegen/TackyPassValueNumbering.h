@@ -0,0 +1,70 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <codegen/TackyAst.h>
+#include <scanner/TokenType.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace billiec::codegen {
+
+/** @brief  Hash-based value numbering over the TACKY of each function.
+ *
+ * Operands are hash-consed into value numbers, constants by value and variables by name, and each
+ * instruction is keyed on its operator and the numbers of its operands, commutative ones in a fixed
+ * order.  An instruction whose key was seen before recomputes a value that's already around, so it
+ * goes and later reads of its result read the earlier one.  One whose operands are all constants
+ * is folded to a constant number instead, so selection still sees it as an immediate.
+ *
+ * A function body is one straight-line block and every temporary is written once, so a single
+ * table per function is enough; with control flow it has to be scoped to the dominator tree.
+ */
+struct TackyPassValueNumbering {
+    TackyNode::PtrType program;
+    std::size_t redundant{0};       ///< Instructions dropped because their value was already computed.
+    std::size_t folded{0};          ///< Instructions dropped because their operands were constants.
+
+    TackyPassValueNumbering(TackyNode::PtrType program):
+        program{std::move(program)} {
+    }
+
+    void process();
+
+private:
+    /** @brief  What a value number stands for, the constant or the variable that first held it. */
+    struct Value {
+        bool is_constant{false};
+        int constant{0};
+        std::string name{};
+    };
+
+    struct ExpressionKey {
+        scanner::TokenType operation{scanner::TokenType::ENDOFFILE};
+        bool unary{false};
+        int lhs{-1};
+        int rhs{-1};
+
+        bool operator==(const ExpressionKey&) const = default;
+    };
+
+    struct ExpressionKeyHash {
+        std::size_t operator()(const ExpressionKey& key) const;
+    };
+
+    std::vector<Value> values_;
+    std::unordered_map<int, int> constant_numbers_;
+    std::unordered_map<std::string, int> variable_numbers_;
+    std::unordered_map<ExpressionKey, int, ExpressionKeyHash> expression_numbers_;
+
+    void number_function_(FunctionTackyNode& function);
+    int number_of_(const TackyNode& operand);
+    int constant_number_(int value);
+    TackyNode::PtrType operand_for_(int value_number) const;
+    bool define_(const TackyNode& dst, const ExpressionKey& key);
+};
+
+} // namespace billiec::codegen
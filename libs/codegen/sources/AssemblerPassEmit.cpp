@@ -1,114 +1,130 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #include <codegen/AssemblerPassEmit.h>
 
+#include <core/Trace.h>
+
+#include <array>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <string_view>
 
+namespace billiec::codegen {
 
+namespace {
 
-namespace billiec::codegen {
+// Generous for "ldr w16, [x17, #16380]" and friends, saves regrowing on the way.
+constexpr std::size_t bytes_per_instruction = 24;
+
+} // namespace
 
 void AssemblerPassEmit::process() {
-    for(auto& curr: instructions) {
-        process_node_(curr);
+    buffer_.clear();
+    std::size_t instruction_count = 0;
+    for(const auto& curr_function: program.functions) {
+        instruction_count += curr_function.instruction_count();
     }
-}
-
-void AssemblerPassEmit::process_node_(AssemblerNode::PtrType& curr_node) {
-    if(auto node = dynamic_cast<ProgramAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<CompoundAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<FunctionAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<MovInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<ReturnInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<LiteralInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<RegisterInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<UnaryInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<AllocateStackInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<DeAllocateStackInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<PseudoRegister*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<Stack*>(curr_node.get())) {
-        visit_node_(*node);
-    } else {
-        // TODO: Error, hey what happen.
+    buffer_.reserve(256 + instruction_count * bytes_per_instruction);
+    
+    buffer_ << "; Generated by billie-c\n";
+    if (emit_timestamp) {
+        auto in_time_t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm local_time{};
+        localtime_r(&in_time_t, &local_time);
+        
+        char timestamp[32];
+        auto length = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %X", &local_time);
+        buffer_ << "; " << std::string_view{timestamp, length} << '\n';
     }
-}
-
-void AssemblerPassEmit::visit_node_(CompoundAssemblerNode& node) {
-    for(auto& curr_node: node.instructions) {
-        process_node_(curr_node);
+    
+    for(const auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        emit_function_(curr_function);
     }
-}
-
-void AssemblerPassEmit::visit_node_(ProgramAssemblerNode& node) {
-    ostream << "; Generated by billie-c\n";
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %X");
-    ostream << "; " << ss.str() << "\n";
     
-    process_node_(node.function_definition);
+    ostream.write(buffer_.view().data(), static_cast<std::streamsize>(buffer_.size()));
 }
 
-void AssemblerPassEmit::visit_node_(FunctionAssemblerNode& node) {
-    ostream << ".global _" << node.name.lexeme << "\n";
-    ostream << "_" << node.name.lexeme << ": \n";
-    for(auto& curr: node.instructions) {
-        process_node_(curr);
+void AssemblerPassEmit::emit_function_(const MachineFunction& function) {
+    buffer_ << ".global _" << function.name << "\n";
+    buffer_ << "_" << function.name << ": \n";
+    for(const auto& curr_block: function.blocks) {
+        for(const auto& curr_ins: curr_block.instructions) {
+            emit_instruction_(curr_ins, function);
+        }
     }
 }
 
-void AssemblerPassEmit::visit_node_(MovInstructionNode& node) {
-    ostream << "mov ";
-    process_node_(node.dst);
-    ostream << ", ";
-    process_node_(node.src);
-    ostream << "\n";
-}
-
-void AssemblerPassEmit::visit_node_(ReturnInstructionNode& node) {
-    ostream << "ret\n";
-}
-
-void AssemblerPassEmit::visit_node_(LiteralInstructionNode& node) {
-    ostream << std::get<int>(node.value);
-}
-
-void AssemblerPassEmit::visit_node_(RegisterInstructionNode& node) {
-    ostream << "w0";
-}
-
-void AssemblerPassEmit::visit_node_(UnaryInstructionNode& node) {
+void AssemblerPassEmit::emit_instruction_(const MachineInstruction& ins, const MachineFunction& function) {
+    switch(ins.opcode) {
+        // Offsets and sizes are immediates, or an x register when they're too big for one.
+        case Opcode::stack_address:
+            buffer_ << "add x" << ins.operands[0].value << ", sp, ";
+            emit_operand_(ins.operands[1], function);
+            buffer_ << '\n';
+            return;
+        case Opcode::allocate_stack:
+            buffer_ << "sub sp, sp, ";
+            emit_operand_(ins.operands[0], function);
+            buffer_ << '\n';
+            return;
+        case Opcode::deallocate_stack:
+            buffer_ << "add sp, sp, ";
+            emit_operand_(ins.operands[0], function);
+            buffer_ << '\n';
+            return;
+        default:
+            break;
+    }
     
+    // The product is 64 bits wide, it's shifted down in the destination's x view.
+    if (ins.opcode == Opcode::smull) {
+        buffer_ << "smull x" << ins.operands[0].value << ", ";
+        emit_operand_(ins.operands[1], function);
+        buffer_ << ", ";
+        emit_operand_(ins.operands[2], function);
+        buffer_ << "\nasr x" << ins.operands[0].value << ", x" << ins.operands[0].value
+                << ", #" << static_cast<int>(ins.shift) << "\n";
+        return;
+    }
+    
+    buffer_ << info_of(ins.opcode).mnemonic;
+    std::string_view separator = " ";
+    for(const auto& curr_operand: ins.operand_slots()) {
+        buffer_ << separator;
+        separator = ", ";
+        emit_operand_(curr_operand, function);
+    }
+    
+    if (ins.opcode == Opcode::movk || ((ins.opcode == Opcode::add || ins.opcode == Opcode::sub) && ins.shift != 0)) {
+        constexpr std::array<std::string_view, 3> shift_kinds = {"lsl", "lsr", "asr"};
+        buffer_ << ", " << shift_kinds[static_cast<std::size_t>(ins.shift_kind)] << " #" << static_cast<int>(ins.shift);
+    } else if (ins.opcode == Opcode::lsl || ins.opcode == Opcode::lsr || ins.opcode == Opcode::asr) {
+        buffer_ << ", #" << static_cast<int>(ins.shift);
+    }
+    buffer_ << '\n';
 }
 
-void AssemblerPassEmit::visit_node_(AllocateStackInstructionNode& node) {
-    ostream << "sub sp, sp, #" << node.size << "\n";
-}
-
-void AssemblerPassEmit::visit_node_(DeAllocateStackInstructionNode& node) {
-    ostream << "add sp, sp, #" << node.size << "\n";
-}
-
-void AssemblerPassEmit::visit_node_(PseudoRegister& node) {
-    ostream << node.identifier;
-}
-
-void AssemblerPassEmit::visit_node_(Stack& node) {
-    ostream << "stack+" << node.offset;
+void AssemblerPassEmit::emit_operand_(const MachineOperand& operand, const MachineFunction& function) {
+    switch(operand.kind) {
+        case OperandKind::reg:
+            buffer_ << (operand.width == RegisterWidth::x ? 'x' : 'w') << operand.value;
+            break;
+        case OperandKind::imm:
+            buffer_ << '#' << operand.value;
+            break;
+        case OperandKind::pseudo:
+            buffer_ << function.pseudo_registers[operand.value].name;
+            break;
+        case OperandKind::stack:
+            if (operand.base != Register::SP) {
+                buffer_ << "[x" << static_cast<int>(operand.base) << ", #" << operand.value << ']';
+            } else {
+                buffer_ << "[sp, #" << operand.value << ']';
+            }
+            break;
+        case OperandKind::none:
+            break;
+    }
 }
 
 } // namespace billiec::codegen
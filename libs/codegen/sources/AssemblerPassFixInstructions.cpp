@@ -1,134 +1,277 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #include <codegen/AssemblerPassFixInstructions.h>
 
+#include <codegen/AssemblerOperands.h>
+#include <core/Trace.h>
+
+#include <array>
+#include <cstdint>
+
 namespace billiec::codegen {
+
+namespace {
+
+// Kept out of register allocation: w16, w17 and w8 carry the sources of an instruction that live in
+// memory or are immediates it can't take, w16 also carries the result.  A load forms a far address
+// in the register it loads, a store in x17 since the value it stores is never in w17.
+constexpr Register scratch_register = Register::W16;
+constexpr Register store_base_register = Register::W17;
+constexpr std::array source_registers = {Register::W16, Register::W17, Register::W8};
+
+// Largest offset ldr/str of a word can encode, it's a 12-bit immediate scaled by 4.
+constexpr int max_word_offset = 4095 * 4;
+
+// add/sub take a 12-bit immediate, optionally shifted left by 12.
+constexpr int max_add_immediate = 4095;
+constexpr int max_shifted_add_immediate = max_add_immediate << 12;
+
+// Largest offset ldp/stp of x registers can encode, a signed 7-bit immediate scaled by 8.
+constexpr int max_pair_offset = 63 * 8;
+
+// Callee-saved registers are saved whole, the caller's upper halves are theirs to keep.
+constexpr int saved_register_size = 8;
+
+MachineOperand scratch() {
+    return MachineOperand::reg(scratch_register);
+}
+
+} // namespace
+
 void AssemblerPassFixInstructions::process() {
-    for(auto& curr_node: instructions) {
-        process_node_(curr_node);
+    for(auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        curr_func = &curr_function;
+        fix_function_(curr_function);
     }
 }
 
-void AssemblerPassFixInstructions::process_node_(AssemblerNode::PtrType& curr_node) {
-    if(auto node = dynamic_cast<ProgramAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<CompoundAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<FunctionAssemblerNode*>(curr_node.get())) {
-        curr_func = node;
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<MovInstructionNode*>(curr_node.get())) {
-        visit_node_(node);
+void AssemblerPassFixInstructions::fix_function_(MachineFunction& function) {
+    for(std::size_t block_idx = 0; block_idx < function.blocks.size(); ++block_idx) {
+        auto& curr_block = function.blocks[block_idx];
+        fixed_.clear();
+        fixed_.reserve(curr_block.instructions.size() + 2 * function.callee_saved_registers.size() + 4);
+        
+        if (block_idx == 0) {
+            emit_prologue_();
+        }
+        for(const auto& curr_ins: curr_block.instructions) {
+            fix_instruction_(curr_ins);
+        }
+        
+        std::swap(curr_block.instructions, fixed_);
     }
 }
 
-void AssemblerPassFixInstructions::visit_node_(CompoundAssemblerNode& node) {
-    for(auto& ins: node.instructions) {
-        process_node_(ins);
+void AssemblerPassFixInstructions::fix_instruction_(MachineInstruction ins) {
+    switch(ins.opcode) {
+        case Opcode::mov:
+            fix_mov_(ins);
+            break;
+        case Opcode::neg:
+        case Opcode::mvn:
+        case Opcode::add:
+        case Opcode::sub:
+        case Opcode::lsl:
+        case Opcode::lsr:
+        case Opcode::asr:
+        case Opcode::mul:
+        case Opcode::smull:
+        case Opcode::sdiv:
+        case Opcode::madd:
+        case Opcode::msub:
+            fix_operation_(ins);
+            break;
+        case Opcode::ret:
+            emit_epilogue_();
+            fixed_.push_back(ins);
+            break;
+        default:
+            fixed_.push_back(ins);
+            break;
     }
 }
 
-void AssemblerPassFixInstructions::visit_node_(ProgramAssemblerNode& node) {
-    process_node_(node.function_definition);
+void AssemblerPassFixInstructions::fix_mov_(MachineInstruction& ins) {
+    auto dst = ins.operands[0];
+    auto src = ins.operands[1];
+    bool dst_slot = dst.is(OperandKind::stack);
+    
+    if (src.is(OperandKind::imm) && (dst_slot || !fits_mov_immediate(src.value))) {
+        if (!dst_slot) {
+            move_immediate_(src.value, dst);
+        } else {
+            move_immediate_(src.value, scratch());
+            fixed_.push_back(MachineInstruction::create(Opcode::str, {scratch(), address_(dst, store_base_register)}));
+        }
+        return;
+    }
+    
+    if (src.is(OperandKind::stack) && dst_slot) {
+        fixed_.push_back(MachineInstruction::create(Opcode::ldr, {scratch(), address_(src, scratch_register)}));
+        fixed_.push_back(MachineInstruction::create(Opcode::str, {scratch(), address_(dst, store_base_register)}));
+    } else if (src.is(OperandKind::stack)) {
+        fixed_.push_back(MachineInstruction::create(Opcode::ldr, {dst, address_(src, store_base_register)}));
+    } else if (dst_slot) {
+        fixed_.push_back(MachineInstruction::create(Opcode::str, {src, address_(dst, store_base_register)}));
+    } else {
+        fixed_.push_back(ins);
+    }
 }
 
-void AssemblerPassFixInstructions::visit_node_(FunctionAssemblerNode& node) {
-    // Stick a stack allocation at the start.
-    auto allocate_stack = AllocateStackInstructionNode::create(stack_size);
-    node.instructions.insert(std::begin(node.instructions), std::move(allocate_stack));
+void AssemblerPassFixInstructions::fix_operation_(MachineInstruction& ins) {
+    // Only add/sub take an immediate, and only an unshifted 12-bit one as the last operand.
+    const auto& rhs = ins.operands[2];
+    bool immediate_rhs = (ins.opcode == Opcode::add || ins.opcode == Opcode::sub) && ins.shift == 0 &&
+                         rhs.is(OperandKind::imm) && rhs.value >= 0 && rhs.value <= max_add_immediate;
     
-    // And de-allocate at the end, before the return.
-    for(auto itr = std::end(node.instructions)-1; itr != std::begin(node.instructions); --itr) {
-        if (check_ret_node_(node.instructions, itr)) {
-            break;
-        }
-        
-        auto compound_node = dynamic_cast<CompoundAssemblerNode*>(itr->get());
-        if (compound_node != nullptr) {
-            for(auto itr2 = std::begin(compound_node->instructions); itr2 != std::end(compound_node->instructions); ++itr2) {
-                if (check_ret_node_(compound_node->instructions, itr2)) {
-                    break;
-                }
-            }
-        }
+    auto sources = ins.operand_slots().subspan(1);
+    for(std::size_t idx = 0; idx < sources.size(); ++idx) {
+        bool allow_immediate = immediate_rhs && idx == 1;
+        sources[idx] = source_(sources[idx], source_registers[idx], allow_immediate);
+    }
+    
+    auto dst = ins.operands[0];
+    if (!dst.is(OperandKind::stack)) {
+        fixed_.push_back(ins);
+        return;
     }
+    
+    // Computed into the scratch register, then stored.
+    ins.operands[0] = scratch();
+    fixed_.push_back(ins);
+    fixed_.push_back(MachineInstruction::create(Opcode::str, {scratch(), address_(dst, store_base_register)}));
 }
 
-bool AssemblerPassFixInstructions::check_ret_node_(std::vector<AssemblerNode::PtrType>& instructions,
-                                                   std::vector<AssemblerNode::PtrType>::iterator itr) {
-    auto ret_node = dynamic_cast<ReturnInstructionNode*>(itr->get());
-    if (ret_node != nullptr) {
-        auto deallocate_stack = DeAllocateStackInstructionNode::create(stack_size);
-        instructions.insert(itr, std::move(deallocate_stack));
-        return true;
+MachineOperand AssemblerPassFixInstructions::source_(MachineOperand operand,
+                                                     Register scratch_source,
+                                                     bool allow_immediate) {
+    if (operand.is(OperandKind::stack)) {
+        fixed_.push_back(MachineInstruction::create(Opcode::ldr, {MachineOperand::reg(scratch_source),
+                                                                  address_(operand, scratch_source)}));
+        return MachineOperand::reg(scratch_source);
     }
-    return false;
+    if (operand.is(OperandKind::imm) && !allow_immediate) {
+        move_immediate_(operand.value, MachineOperand::reg(scratch_source));
+        return MachineOperand::reg(scratch_source);
+    }
+    return operand;
 }
 
-void AssemblerPassFixInstructions::visit_node_(MovInstructionNode* node) {
-    // Find the instruction that this corresponds in the "current" function.
-    if (curr_func == nullptr) {
-        // TODO: Error..
+void AssemblerPassFixInstructions::move_immediate_(int value, MachineOperand dst) {
+    if (fits_mov_immediate(value)) {
+        fixed_.push_back(MachineInstruction::create(Opcode::mov, {dst, MachineOperand::imm(value)}));
+        return;
     }
     
-    auto find_lambda = [node](const std::vector<AssemblerNode::PtrType>& ins) {
-        auto itr = std::find_if(std::begin(ins), std::end(ins), [node](const auto& curr) {
-            if (curr.get() == node) {
-                return true;
-            }
-            return false;
-        });
-        
-        return itr;
-    };
-    
-    // Check the current function.
-    bool found = false;
-    auto itr = find_lambda(curr_func->instructions);
-    if (itr == std::end(curr_func->instructions)) {
-        // Also check in compound nodes.
-        for(auto itr2 = std::begin(curr_func->instructions); itr2 != std::end(curr_func->instructions); ++itr2) {
-            auto compound = dynamic_cast<CompoundAssemblerNode*>(itr2->get());
-            if (compound != nullptr) {
-                itr = find_lambda(compound->instructions);
-                if (itr != std::end(compound->instructions)) {
-                    found = true;
-                    break;
-                }
-            }
-        }
-    } else {
-        found = true;
+    // Low half with movz, high half with movk.
+    auto bits = static_cast<std::uint32_t>(value);
+    fixed_.push_back(MachineInstruction::create(Opcode::mov, {dst, MachineOperand::imm(static_cast<int>(bits & 0xffffu))}));
+    fixed_.push_back(MachineInstruction::create(Opcode::movk, {dst, MachineOperand::imm(static_cast<int>(bits >> 16))}, 16));
+}
+
+MachineOperand AssemblerPassFixInstructions::address_(MachineOperand slot, Register base) {
+    if (slot.value <= max_word_offset) {
+        return slot;
     }
     
-    if (!found) {
-        // TODO: Error..
+    // Too far for the immediate offset, step the base most of the way first.
+    int high = slot.value & ~max_add_immediate;
+    step_base_(base, high);
+    return MachineOperand::stack(slot.value - high, base);
+}
+
+void AssemblerPassFixInstructions::step_base_(Register base, int offset) {
+    if (offset <= max_shifted_add_immediate) {
+        fixed_.push_back(MachineInstruction::create(Opcode::stack_address, {MachineOperand::reg(base), MachineOperand::imm(offset)}));
+        return;
     }
     
-    // Check if there's any local stack vars.
-    auto mov_ins = dynamic_cast<MovInstructionNode*>(itr->get());
-    if (mov_ins == nullptr) {
-        // TODO: Error.
+    // Past what a shifted immediate reaches, the offset goes through the base register itself.
+    move_immediate_(offset, MachineOperand::reg(base));
+    fixed_.push_back(MachineInstruction::create(Opcode::stack_address, {MachineOperand::reg(base),
+                                                                        MachineOperand::reg(base, RegisterWidth::x)}));
+}
+
+void AssemblerPassFixInstructions::emit_prologue_() {
+    // Stick a stack allocation at the start, callee-saved registers the allocator used go
+    // right above the locals.
+    adjust_stack_(frame_size_(*curr_func), true);
+    transfer_callee_saved_(Opcode::str, Opcode::stp);
+}
+
+void AssemblerPassFixInstructions::emit_epilogue_() {
+    transfer_callee_saved_(Opcode::ldr, Opcode::ldp);
+    adjust_stack_(frame_size_(*curr_func), false);
+}
+
+void AssemblerPassFixInstructions::transfer_callee_saved_(Opcode single, Opcode pair) {
+    const auto& saved = curr_func->callee_saved_registers;
+    if (saved.empty()) {
+        return;
     }
     
-    // Check if source or dest are pseudo-registers and replace with the appropriate instructions.
-    std::vector<AssemblerNode::PtrType> instructions;
-    auto src_stack = dynamic_cast<PseudoRegister*>(mov_ins->src.get());
-    if (src_stack != nullptr) {
-        
+    // Pairs only reach so far from sp, past that x17 points at the save area first.  Nothing is
+    // live in it at either end of the function.
+    auto base = Register::SP;
+    int offset = save_area_offset_();
+    if (offset + saved_register_size * static_cast<int>(saved.size() - 1) > max_pair_offset) {
+        point_at_(store_base_register, offset);
+        base = store_base_register;
+        offset = 0;
     }
     
-    auto dst_stack = dynamic_cast<PseudoRegister*>(mov_ins->src.get());
-    if (dst_stack != nullptr) {
-        
+    for(std::size_t idx = 0; idx < saved.size(); idx += 2) {
+        auto slot = MachineOperand::stack(offset + saved_register_size * static_cast<int>(idx), base);
+        auto first = MachineOperand::reg(saved[idx], RegisterWidth::x);
+        if (idx + 1 < saved.size()) {
+            auto second = MachineOperand::reg(saved[idx + 1], RegisterWidth::x);
+            fixed_.push_back(MachineInstruction::create(pair, {first, second, slot}));
+        } else {
+            fixed_.push_back(MachineInstruction::create(single, {first, slot}));
+        }
     }
+}
+
+void AssemblerPassFixInstructions::point_at_(Register base, int offset) {
+    // Offsets past 4K take a shifted chunk and then the remainder.
+    int high = offset & ~max_add_immediate;
+    int low = offset & max_add_immediate;
+    step_base_(base, high);
+    if (low != 0) {
+        auto x_base = MachineOperand::reg(base, RegisterWidth::x);
+        fixed_.push_back(MachineInstruction::create(Opcode::add, {x_base, x_base, MachineOperand::imm(low)}));
+    }
+}
+
+void AssemblerPassFixInstructions::adjust_stack_(int size, bool allocate) {
+    auto opcode = allocate ? Opcode::allocate_stack : Opcode::deallocate_stack;
     
+    // Frames of 16M and up take the size in w16, nothing is live in it at either end of the function.
+    if (size > max_shifted_add_immediate + max_add_immediate) {
+        move_immediate_(size, scratch());
+        fixed_.push_back(MachineInstruction::create(opcode, {MachineOperand::reg(scratch_register, RegisterWidth::x)}));
+        return;
+    }
     
-    
-    
-    // Replace the instruction with a compound instruction.
-//    std::vector<AssemblerNode::PtrType> instructions;
-//    instructions.push_back(
-    
+    // Frames past 4K take a shifted chunk and then the remainder, an empty frame takes nothing.
+    int high = size & ~max_add_immediate;
+    int low = size & max_add_immediate;
+    for(int chunk: {high, low}) {
+        if (chunk == 0) {
+            continue;
+        }
+        fixed_.push_back(MachineInstruction::create(opcode, {MachineOperand::imm(chunk)}));
+    }
+}
+
+int AssemblerPassFixInstructions::frame_size_(const MachineFunction& function) const {
+    // AArch64 faults on sp that isn't 16-byte aligned.
+    int frame_size = save_area_offset_() + saved_register_size * static_cast<int>(function.callee_saved_registers.size());
+    return (frame_size + 15) & ~15;
+}
+
+int AssemblerPassFixInstructions::save_area_offset_() const {
+    return (stack_size + saved_register_size - 1) & ~(saved_register_size - 1);
 }
 
 } // namespace billiec::codegen
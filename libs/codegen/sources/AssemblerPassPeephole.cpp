@@ -0,0 +1,203 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/AssemblerPassPeephole.h>
+
+#include <codegen/AssemblerOperands.h>
+#include <core/Trace.h>
+
+#include <array>
+#include <cstdint>
+
+namespace billiec::codegen {
+
+namespace {
+
+using InstructionList = std::vector<MachineInstruction>;
+
+/** @brief  A rewrite of the last \c window instructions, \c apply returns true when it changed them. */
+struct PeepholeRule {
+    const char* name;
+    std::size_t window;
+    bool (*apply)(InstructionList& out);
+};
+
+// The instruction \c back places from the end, if it has the opcode.
+MachineInstruction* tail_as(InstructionList& out, std::size_t back, Opcode opcode) {
+    auto& ins = out[out.size() - 1 - back];
+    return ins.opcode == opcode ? &ins : nullptr;
+}
+
+bool is_unary(const MachineInstruction& ins) {
+    return ins.opcode == Opcode::neg || ins.opcode == Opcode::mvn;
+}
+
+// Registers and slots are the same place when they compare equal, immediates never are a place.
+bool same_operand(const MachineOperand& lhs, const MachineOperand& rhs) {
+    return (lhs.is(OperandKind::reg) || lhs.is(OperandKind::stack)) && lhs == rhs;
+}
+
+bool is_register(const MachineOperand& operand) {
+    return operand.is(OperandKind::reg);
+}
+
+// mov wA, wA
+bool remove_self_move(InstructionList& out) {
+    auto mov = tail_as(out, 0, Opcode::mov);
+    if (mov == nullptr || !is_register(mov->operands[0]) || !same_operand(mov->operands[1], mov->operands[0])) {
+        return false;
+    }
+    out.pop_back();
+    return true;
+}
+
+// mov wB, wA; mov wA, wB  ->  mov wB, wA
+bool remove_copy_back(InstructionList& out) {
+    auto first = tail_as(out, 1, Opcode::mov);
+    auto second = tail_as(out, 0, Opcode::mov);
+    if (first == nullptr || second == nullptr ||
+        !is_register(first->operands[1]) || !is_register(first->operands[0]) ||
+        !same_operand(first->operands[1], second->operands[0]) ||
+        !same_operand(first->operands[0], second->operands[1])) {
+        return false;
+    }
+    out.pop_back();
+    return true;
+}
+
+// mov wB, x; mov wB, y  ->  mov wB, y   as long as y isn't wB itself, same for loads into wB.
+bool remove_overwritten_move(InstructionList& out) {
+    const auto& first = out[out.size() - 2];
+    const auto& second = out.back();
+    if ((first.opcode != Opcode::mov && first.opcode != Opcode::ldr) || !is_register(first.operands[0])) {
+        return false;
+    }
+    
+    const auto& first_dst = first.operands[0];
+    if (second.opcode == Opcode::mov) {
+        if (!same_operand(first_dst, second.operands[0]) || same_operand(first_dst, second.operands[1])) {
+            return false;
+        }
+    } else if (second.opcode == Opcode::ldr) {
+        if (!same_operand(first_dst, second.operands[0])) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    out.erase(out.end() - 2);
+    return true;
+}
+
+// str wA, [s]; ldr wB, [s]  ->  str wA, [s]; mov wB, wA
+bool forward_store_to_load(InstructionList& out) {
+    auto store = tail_as(out, 1, Opcode::str);
+    auto load = tail_as(out, 0, Opcode::ldr);
+    if (store == nullptr || load == nullptr || !same_operand(store->operands[1], load->operands[1])) {
+        return false;
+    }
+    
+    if (same_operand(store->operands[0], load->operands[0])) {
+        out.pop_back();
+    } else {
+        out.back() = MachineInstruction::create(Opcode::mov, {load->operands[0], store->operands[0]});
+    }
+    return true;
+}
+
+// ldr wA, [s]; str wA, [s]  ->  ldr wA, [s]
+bool remove_store_of_load(InstructionList& out) {
+    auto load = tail_as(out, 1, Opcode::ldr);
+    auto store = tail_as(out, 0, Opcode::str);
+    if (load == nullptr || store == nullptr ||
+        !same_operand(load->operands[1], store->operands[1]) ||
+        !same_operand(load->operands[0], store->operands[0])) {
+        return false;
+    }
+    out.pop_back();
+    return true;
+}
+
+// mov wB, #v; neg wB, wB  ->  mov wB, #-v   (and ~v for mvn) when mov can still encode it.
+bool fold_unary_immediate(InstructionList& out) {
+    auto mov = tail_as(out, 1, Opcode::mov);
+    auto& unary = out.back();
+    if (mov == nullptr || !is_unary(unary) || !mov->operands[1].is(OperandKind::imm) ||
+        !same_operand(mov->operands[0], unary.operands[0]) || !same_operand(mov->operands[0], unary.operands[1])) {
+        return false;
+    }
+    
+    auto bits = static_cast<std::uint32_t>(mov->operands[1].value);
+    bits = unary.opcode == Opcode::neg ? 0u - bits : ~bits;
+    int folded = static_cast<int>(bits);
+    if (!fits_mov_immediate(folded)) {
+        return false;
+    }
+    
+    mov->operands[1].value = folded;
+    out.pop_back();
+    return true;
+}
+
+// mov wB, wA; neg wB, wB  ->  neg wB, wA
+bool combine_mov_unary(InstructionList& out) {
+    auto mov = tail_as(out, 1, Opcode::mov);
+    const auto& unary = out.back();
+    if (mov == nullptr || !is_unary(unary) || !is_register(mov->operands[1]) ||
+        !same_operand(mov->operands[0], unary.operands[0]) || !same_operand(mov->operands[0], unary.operands[1])) {
+        return false;
+    }
+    
+    auto combined = MachineInstruction::create(unary.opcode, {mov->operands[0], mov->operands[1]});
+    out.pop_back();
+    out.back() = combined;
+    return true;
+}
+
+constexpr std::array<PeepholeRule, 7> peephole_rules = {{
+    {"self-move", 1, &remove_self_move},
+    {"copy-back", 2, &remove_copy_back},
+    {"overwritten-move", 2, &remove_overwritten_move},
+    {"store-to-load", 2, &forward_store_to_load},
+    {"store-of-load", 2, &remove_store_of_load},
+    {"fold-unary-immediate", 2, &fold_unary_immediate},
+    {"combine-mov-unary", 2, &combine_mov_unary},
+}};
+
+} // namespace
+
+void AssemblerPassPeephole::process() {
+    for(const auto& curr_rule: peephole_rules) {
+        stats.try_emplace(curr_rule.name, 0);
+    }
+    
+    for(auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        for(auto& curr_block: curr_function.blocks) {
+            optimize_block_(curr_block);
+        }
+    }
+}
+
+void AssemblerPassPeephole::optimize_block_(MachineBlock& block) {
+    InstructionList out;
+    out.reserve(block.instructions.size());
+    for(const auto& curr_ins: block.instructions) {
+        out.push_back(curr_ins);
+        
+        // Keep going until the tail settles, one rewrite often lines up the next.
+        bool changed = true;
+        while(changed && !out.empty()) {
+            changed = false;
+            for(const auto& curr_rule: peephole_rules) {
+                if (out.size() >= curr_rule.window && curr_rule.apply(out)) {
+                    ++stats[curr_rule.name];
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    
+    block.instructions = std::move(out);
+}
+
+} // namespace billiec::codegen
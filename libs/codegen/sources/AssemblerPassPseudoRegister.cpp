@@ -1,85 +1,84 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #include <codegen/AssemblerPassPseudoRegister.h>
 
+#include <codegen/LivenessAnalysis.h>
+#include <core/Trace.h>
+
+#include <algorithm>
+#include <map>
+#include <queue>
+
 namespace billiec::codegen {
 
 int AssemblerPassPseudoRegister::process() {
     // Look for all pseudo-registers and replace them with their offset.
-    for(auto& curr_ins: instructions) {
-        process_node_(curr_ins);
-    }
-    
-    if (offsets.empty()) {
-        return 0;
+    std::vector<int> slot_offsets;
+    for(auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        stack_size_ = std::max(stack_size_, color_slots_(curr_function, slot_offsets));
+        
+        for(auto& curr_block: curr_function.blocks) {
+            for(auto& curr_ins: curr_block.instructions) {
+                for(auto& curr_operand: curr_ins.operand_slots()) {
+                    if (curr_operand.is(OperandKind::pseudo)) {
+                        curr_operand = MachineOperand::stack(slot_offsets[curr_operand.value]);
+                    }
+                }
+            }
+        }
     }
     
-    // This is how much we need to allocate on the stack.
-    return offsets.size() * 4;
-}
-
-void AssemblerPassPseudoRegister::process_node_(AssemblerNode::PtrType& curr_node) {
-    if(auto node = dynamic_cast<ProgramAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<CompoundAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<FunctionAssemblerNode*>(curr_node.get())) {
-        visit_node_(*node);
-    } else if (auto node = dynamic_cast<MovInstructionNode*>(curr_node.get())) {
-        visit_node_(*node);
-    }
-}
-
-void AssemblerPassPseudoRegister::visit_node_(CompoundAssemblerNode& node) {
-    for(auto& curr_node: node.instructions) {
-        process_node_(curr_node);
-    }
+    // This is how much we need to allocate on the stack for the slots, the prologue rounds the
+    // whole frame up to keep sp aligned.
+    return stack_size_;
 }
 
-void AssemblerPassPseudoRegister::visit_node_(ProgramAssemblerNode& node) {
-    process_node_(node.function_definition);
-}
-
-void AssemblerPassPseudoRegister::visit_node_(FunctionAssemblerNode& node) {
-    for(auto& curr_node: node.instructions) {
-        process_node_(curr_node);
-    }
-}
-
-void AssemblerPassPseudoRegister::visit_node_(MovInstructionNode& node) {
-    PseudoRegister* pseudo_register = dynamic_cast<PseudoRegister*>(node.src.get());
-    if (pseudo_register != nullptr) {
-        int offset = get_offset_(pseudo_register->identifier);
-        auto stack_ins = Stack::create(offset);
-        node.src = std::move(stack_ins);
-    }
+int AssemblerPassPseudoRegister::color_slots_(MachineFunction& function, std::vector<int>& slot_offsets) {
+    LivenessAnalysis liveness{function};
+    liveness.process();
+    auto ranges = liveness.live_ranges();
     
-    pseudo_register = dynamic_cast<PseudoRegister*>(node.dst.get());
-    if (pseudo_register != nullptr) {
-        int offset = get_offset_(pseudo_register->identifier);
-        auto stack_ins = Stack::create(offset);
-        node.dst = std::move(stack_ins);
+    // Whatever register allocation placed is no longer mentioned and needs no slot.
+    std::vector<int> order;
+    for(int idx = 0; idx < static_cast<int>(ranges.size()); ++idx) {
+        if (ranges[idx].end >= 0) {
+            order.push_back(idx);
+        }
     }
-}
-
-int AssemblerPassPseudoRegister::get_offset_(const std::string& pseudo_register) {
-    if (offsets.empty()) {
-        offsets.push_back(std::make_pair(pseudo_register, 0));
-    } else {
-        auto itr = std::find_if(std::begin(offsets), std::end(offsets), [&pseudo_register](const auto& curr) {
-            if (curr.first == pseudo_register) {
-                return true;
-            }
-            return false;
-        });
-        if (itr == std::end(offsets)) {
-            int curr_offset = offsets.back().second;
-            offsets.push_back(std::make_pair(pseudo_register, curr_offset+4));
+    std::stable_sort(std::begin(order), std::end(order), [&ranges](int lhs, int rhs) {
+        return ranges[lhs].start < ranges[rhs].start;
+    });
+    
+    // Walk the ranges by start, a slot goes back in its size's free list once its owner dies.
+    const auto& pseudo_registers = function.pseudo_registers;
+    slot_offsets.assign(ranges.size(), 0);
+    std::map<int, std::vector<int>> free_slots;
+    using ActiveSlot = std::pair<int, int>;   // (end, pseudo-register)
+    std::priority_queue<ActiveSlot, std::vector<ActiveSlot>, std::greater<>> active;
+    int frame_size = 0;
+    for(int curr_idx: order) {
+        while(!active.empty() && active.top().first <= ranges[curr_idx].start) {
+            int expired = active.top().second;
+            active.pop();
+            free_slots[pseudo_registers[expired].size].push_back(slot_offsets[expired]);
+        }
+        
+        int size = pseudo_registers[curr_idx].size;
+        auto& pool = free_slots[size];
+        if (!pool.empty()) {
+            slot_offsets[curr_idx] = pool.back();
+            pool.pop_back();
         } else {
-            return itr->second;
+            // Slots are naturally aligned.
+            frame_size = (frame_size + size - 1) / size * size;
+            slot_offsets[curr_idx] = frame_size;
+            frame_size += size;
         }
+        
+        active.emplace(ranges[curr_idx].end, curr_idx);
     }
     
-    return offsets.back().second;
+    return frame_size;
 }
 
 } // namespace billiec::codegen
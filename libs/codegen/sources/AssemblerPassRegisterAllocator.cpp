@@ -0,0 +1,216 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/AssemblerPassRegisterAllocator.h>
+
+#include <codegen/AssemblerOperands.h>
+#include <codegen/LivenessAnalysis.h>
+#include <core/Trace.h>
+
+#include <algorithm>
+#include <array>
+#include <set>
+
+namespace billiec::codegen {
+
+namespace {
+
+// Free to clobber, so these are tried first.  Nothing makes calls yet, so the argument registers
+// are free too; w0 stays out for the return value and w8, w16 and w17 as scratch registers.
+constexpr std::array caller_saved_registers = {
+    Register::W1, Register::W2, Register::W3, Register::W4,
+    Register::W5, Register::W6, Register::W7,
+    Register::W9, Register::W10, Register::W11, Register::W12,
+    Register::W13, Register::W14, Register::W15
+};
+
+// Only used when the caller-saved ones run out, the prologue has to save them.
+constexpr std::array callee_saved_registers = {
+    Register::W19, Register::W20, Register::W21, Register::W22, Register::W23,
+    Register::W24, Register::W25, Register::W26, Register::W27, Register::W28
+};
+
+constexpr std::size_t register_count = static_cast<std::size_t>(Register::W28) + 1;
+
+} // namespace
+
+void AssemblerPassRegisterAllocator::process() {
+    for(auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        allocate_(curr_function);
+    }
+}
+
+void AssemblerPassRegisterAllocator::allocate_(MachineFunction& function) {
+    intervals_.clear();
+    interval_idx_.assign(function.pseudo_registers.size(), -1);
+
+    LivenessAnalysis liveness{function};
+    liveness.process();
+    build_intervals_(liveness);
+
+    RegisterAllocationStats func_stats;
+    func_stats.intervals = static_cast<int>(intervals_.size());
+    scan_(function, func_stats);
+    rewrite_(liveness);
+    remove_dropped_(function);
+
+    stats[function.name] = func_stats;
+}
+
+void AssemblerPassRegisterAllocator::build_intervals_(const LivenessAnalysis& liveness) {
+    auto ranges = liveness.live_ranges();
+    std::vector<Interval> by_pseudo(ranges.size());
+    for(std::size_t idx = 0; idx < by_pseudo.size(); ++idx) {
+        by_pseudo[idx].pseudo_register = static_cast<int>(idx);
+        by_pseudo[idx].start = ranges[idx].start;
+        by_pseudo[idx].end = ranges[idx].end;
+    }
+
+    for(int position = 0; position < static_cast<int>(liveness.instructions.size()); ++position) {
+        const auto& curr_ins = *liveness.instructions[position];
+        for(int curr_def: liveness.defs(position)) {
+            auto& interval = by_pseudo[curr_def];
+            ++interval.defs;
+            if (curr_ins.opcode == Opcode::mov && curr_ins.operands[1].is(OperandKind::imm)) {
+                interval.constant = curr_ins.operands[1].value;
+                interval.constant_def = position;
+            } else {
+                interval.constant.reset();
+                interval.constant_def = -1;
+            }
+        }
+    }
+
+    // Only something written exactly once from a literal can be rematerialized.
+    for(auto& curr_interval: by_pseudo) {
+        if (curr_interval.end < 0) {
+            continue;
+        }
+        if (curr_interval.defs != 1) {
+            curr_interval.constant.reset();
+            curr_interval.constant_def = -1;
+        }
+        intervals_.push_back(curr_interval);
+    }
+
+    std::stable_sort(std::begin(intervals_), std::end(intervals_), [](const Interval& lhs, const Interval& rhs) {
+        return lhs.start < rhs.start;
+    });
+    for(std::size_t idx = 0; idx < intervals_.size(); ++idx) {
+        interval_idx_[intervals_[idx].pseudo_register] = static_cast<int>(idx);
+    }
+}
+
+void AssemblerPassRegisterAllocator::scan_(MachineFunction& function, RegisterAllocationStats& func_stats) {
+    std::array<bool, register_count> in_use{};
+    std::set<Register> callee_saved_used;
+    std::vector<std::size_t> active;
+
+    auto take_free_register = [&]() -> std::optional<Register> {
+        for(auto curr_reg: caller_saved_registers) {
+            if (!in_use[static_cast<std::size_t>(curr_reg)]) {
+                return curr_reg;
+            }
+        }
+        for(auto curr_reg: callee_saved_registers) {
+            if (!in_use[static_cast<std::size_t>(curr_reg)]) {
+                callee_saved_used.insert(curr_reg);
+                return curr_reg;
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto spill = [&](Interval& interval) {
+        interval.assigned.reset();
+        interval.spilled = true;
+        if (interval.constant.has_value()) {
+            ++func_stats.rematerialized;
+        } else {
+            ++func_stats.spills;
+        }
+    };
+
+    for(std::size_t idx = 0; idx < intervals_.size(); ++idx) {
+        auto& curr_interval = intervals_[idx];
+
+        // An interval ending where this one starts only reads its register before we write it.
+        std::erase_if(active, [&](std::size_t active_idx) {
+            if (intervals_[active_idx].end <= curr_interval.start) {
+                in_use[static_cast<std::size_t>(*intervals_[active_idx].assigned)] = false;
+                return true;
+            }
+            return false;
+        });
+
+        if (auto free_register = take_free_register()) {
+            curr_interval.assigned = free_register;
+            in_use[static_cast<std::size_t>(*free_register)] = true;
+            active.push_back(idx);
+            continue;
+        }
+
+        // Out of registers.  Constants are free to spill since they are re-emitted at each use,
+        // otherwise the interval reaching furthest gives up its register.
+        if (curr_interval.constant.has_value()) {
+            spill(curr_interval);
+            continue;
+        }
+
+        auto victim_itr = std::max_element(std::begin(active), std::end(active), [this](std::size_t lhs, std::size_t rhs) {
+            const auto& lhs_interval = intervals_[lhs];
+            const auto& rhs_interval = intervals_[rhs];
+            if (lhs_interval.constant.has_value() != rhs_interval.constant.has_value()) {
+                return !lhs_interval.constant.has_value();
+            }
+            return lhs_interval.end < rhs_interval.end;
+        });
+
+        auto& victim = intervals_[*victim_itr];
+        if (victim.constant.has_value() || victim.end > curr_interval.end) {
+            curr_interval.assigned = victim.assigned;
+            spill(victim);
+            *victim_itr = idx;
+        } else {
+            spill(curr_interval);
+        }
+    }
+
+    function.callee_saved_registers.assign(std::begin(callee_saved_used), std::end(callee_saved_used));
+    func_stats.callee_saved_used = static_cast<int>(callee_saved_used.size());
+}
+
+void AssemblerPassRegisterAllocator::rewrite_(const LivenessAnalysis& liveness) {
+    for(auto curr_ins: liveness.instructions) {
+        for_each_operand(*curr_ins, [&](MachineOperand& operand, bool, bool) {
+            if (!operand.is(OperandKind::pseudo)) {
+                return;
+            }
+
+            const auto& interval = intervals_[interval_idx_[operand.value]];
+            if (interval.assigned) {
+                operand = MachineOperand::reg(*interval.assigned);
+            } else if (interval.constant) {
+                operand = MachineOperand::imm(*interval.constant);
+            }
+        });
+    }
+
+    // The moves that produced rematerialized constants have no readers left.
+    dropped_.assign(liveness.instructions.size(), false);
+    for(auto& curr_interval: intervals_) {
+        if (curr_interval.spilled && curr_interval.constant_def >= 0) {
+            dropped_[curr_interval.constant_def] = true;
+        }
+    }
+}
+
+void AssemblerPassRegisterAllocator::remove_dropped_(MachineFunction& function) {
+    std::size_t position = 0;
+    for(auto& curr_block: function.blocks) {
+        std::erase_if(curr_block.instructions, [&](const MachineInstruction&) {
+            return dropped_[position++];
+        });
+    }
+}
+
+} // namespace billiec::codegen
@@ -0,0 +1,324 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/AssemblerPassScheduler.h>
+
+#include <codegen/AssemblerOperands.h>
+#include <core/Trace.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+
+namespace billiec::codegen {
+
+namespace {
+
+// Everything an instruction can depend through gets a key: registers use their number, the rest
+// sit above them.  Slots at far offsets are only reachable through a scratch base, so they never
+// alias the sp-relative ones and are lumped together.
+constexpr int sp_key = 64;
+constexpr int far_memory_key = 66;
+constexpr int slot_key_base = 128;
+
+struct Effects {
+    PipelineClass pipeline{PipelineClass::integer_alu};
+    std::vector<int> reads;
+    std::vector<int> writes;
+};
+
+int base_key(const MachineOperand& slot) {
+    return slot.base == Register::SP ? sp_key : static_cast<int>(slot.base);
+}
+
+int memory_key(const MachineOperand& slot) {
+    return slot.base == Register::SP ? slot_key_base + slot.value : far_memory_key;
+}
+
+// Registers an instruction reads or writes through its operand slots, slots count as reads of
+// their base and of the memory behind them.
+void add_operand_effects(const MachineInstruction& ins, Effects& effects) {
+    const auto& info = info_of(ins.opcode);
+    for(std::size_t idx = 0; idx < info.operand_count; ++idx) {
+        const auto& operand = ins.operands[idx];
+        auto role = static_cast<std::uint8_t>(info.roles[idx]);
+        if (operand.is(OperandKind::reg)) {
+            if ((role & static_cast<std::uint8_t>(OperandRole::use)) != 0) {
+                effects.reads.push_back(operand.value);
+            }
+            if ((role & static_cast<std::uint8_t>(OperandRole::def)) != 0) {
+                effects.writes.push_back(operand.value);
+            }
+        } else if (operand.is(OperandKind::stack)) {
+            // A pair covers the slot after the first as well.
+            effects.reads.push_back(base_key(operand));
+            auto& accesses = ins.opcode == Opcode::str || ins.opcode == Opcode::stp ? effects.writes : effects.reads;
+            accesses.push_back(memory_key(operand));
+            if (ins.opcode == Opcode::ldp || ins.opcode == Opcode::stp) {
+                accesses.push_back(memory_key(MachineOperand::stack(operand.value + 8, operand.base)));
+            }
+        }
+    }
+}
+
+// What the instruction reads and writes, or nothing if the scheduler has to leave it alone.
+std::optional<Effects> effects_of(const MachineInstruction& ins) {
+    Effects effects;
+    switch(ins.opcode) {
+        case Opcode::mov:
+        case Opcode::movk:
+        case Opcode::neg:
+        case Opcode::mvn:
+        case Opcode::add:
+        case Opcode::sub:
+        case Opcode::lsl:
+        case Opcode::lsr:
+        case Opcode::asr:
+            break;
+        case Opcode::mul:
+        case Opcode::smull:
+        case Opcode::madd:
+        case Opcode::msub:
+            effects.pipeline = PipelineClass::integer_multiply;
+            break;
+        case Opcode::sdiv:
+            effects.pipeline = PipelineClass::integer_divide;
+            break;
+        case Opcode::ldr:
+        case Opcode::ldp:
+            effects.pipeline = PipelineClass::load;
+            break;
+        case Opcode::str:
+        case Opcode::stp:
+            effects.pipeline = PipelineClass::store;
+            break;
+        case Opcode::stack_address:
+        case Opcode::allocate_stack:
+        case Opcode::deallocate_stack:
+            effects.reads.push_back(sp_key);
+            if (ins.opcode != Opcode::stack_address) {
+                effects.writes.push_back(sp_key);
+            }
+            break;
+        default:
+            return std::nullopt;
+    }
+    add_operand_effects(ins, effects);
+    return effects;
+}
+
+} // namespace
+
+void AssemblerPassScheduler::process() {
+    for(auto& curr_function: program.functions) {
+        TraceSpan span{"function", curr_function.name};
+        ScheduleStats func_stats;
+        func_stats.instructions = static_cast<int>(curr_function.instruction_count());
+        for(auto& curr_block: curr_function.blocks) {
+            schedule_block_(curr_block, func_stats);
+        }
+        stats[curr_function.name] = func_stats;
+    }
+}
+
+void AssemblerPassScheduler::schedule_block_(MachineBlock& block, ScheduleStats& func_stats) {
+    // Regions are the runs between instructions we can't move, a block's return is one of them.
+    std::span<const MachineInstruction> instructions{block.instructions};
+    std::vector<MachineInstruction> scheduled;
+    scheduled.reserve(instructions.size());
+    std::size_t region_begin = 0;
+    for(std::size_t idx = 0; idx < instructions.size(); ++idx) {
+        if (effects_of(instructions[idx])) {
+            continue;
+        }
+        schedule_region_(instructions.subspan(region_begin, idx - region_begin), scheduled, func_stats);
+        region_begin = idx + 1;
+        scheduled.push_back(instructions[idx]);
+        ++func_stats.cycles_before;
+        ++func_stats.cycles_after;
+    }
+    schedule_region_(instructions.subspan(region_begin), scheduled, func_stats);
+
+    block.instructions = std::move(scheduled);
+}
+
+void AssemblerPassScheduler::schedule_region_(std::span<const MachineInstruction> region,
+                                              std::vector<MachineInstruction>& scheduled,
+                                              ScheduleStats& func_stats) {
+    if (region.empty()) {
+        return;
+    }
+
+    build_graph_(region);
+    std::vector<int> original_order(region.size());
+    for(std::size_t idx = 0; idx < region.size(); ++idx) {
+        original_order[idx] = static_cast<int>(idx);
+    }
+    auto order = list_schedule_();
+
+    int cycles_before = estimate_cycles_(original_order);
+    int cycles_after = estimate_cycles_(order);
+    if (cycles_after > cycles_before) {
+        // The greedy choice can lose on an in-order core, keep what we had then.
+        order = std::move(original_order);
+        cycles_after = cycles_before;
+    }
+    func_stats.cycles_before += cycles_before;
+    func_stats.cycles_after += cycles_after;
+
+    for(int curr_idx: order) {
+        scheduled.push_back(region[curr_idx]);
+    }
+}
+
+void AssemblerPassScheduler::build_graph_(std::span<const MachineInstruction> region) {
+    struct KeyState {
+        int last_writer{-1};
+        std::vector<int> readers;
+    };
+    std::unordered_map<int, KeyState> keys;
+
+    nodes_.assign(region.size(), Node{});
+    auto add_edge = [this](int from, int to, int latency) {
+        nodes_[from].successors.push_back(Edge{.to = to, .latency = latency});
+        ++nodes_[to].predecessors;
+    };
+
+    for(int idx = 0; idx < static_cast<int>(region.size()); ++idx) {
+        auto effects = *effects_of(region[idx]);
+        nodes_[idx].pipeline = effects.pipeline;
+
+        for(int curr_key: effects.reads) {
+            auto& state = keys[curr_key];
+            if (state.last_writer >= 0) {
+                add_edge(state.last_writer, idx, model.latency_of(nodes_[state.last_writer].pipeline));
+            }
+            state.readers.push_back(idx);
+        }
+
+        for(int curr_key: effects.writes) {
+            auto& state = keys[curr_key];
+            if (state.last_writer >= 0 && state.last_writer != idx) {
+                add_edge(state.last_writer, idx, 1);
+            }
+            for(int curr_reader: state.readers) {
+                if (curr_reader != idx) {
+                    add_edge(curr_reader, idx, 0);
+                }
+            }
+            state.last_writer = idx;
+            state.readers.clear();
+        }
+    }
+
+    // Height is the longest latency path from the instruction to the end of the region.
+    for(int idx = static_cast<int>(nodes_.size()) - 1; idx >= 0; --idx) {
+        auto& curr_node = nodes_[idx];
+        curr_node.height = model.latency_of(curr_node.pipeline);
+        for(const auto& curr_edge: curr_node.successors) {
+            curr_node.height = std::max(curr_node.height, curr_edge.latency + nodes_[curr_edge.to].height);
+        }
+    }
+}
+
+std::vector<int> AssemblerPassScheduler::list_schedule_() {
+    int node_count = static_cast<int>(nodes_.size());
+    std::vector<int> order;
+    order.reserve(node_count);
+    std::vector<int> earliest(node_count, 0);
+    std::vector<int> remaining(node_count, 0);
+
+    // Ready by longest path first, ties go to whatever came first originally.  Each pipeline
+    // class queues separately so a class that's out of pipes for the cycle is skipped whole.
+    using ReadyEntry = std::pair<int, int>;     // (height, -index)
+    using WaitingEntry = std::pair<int, int>;   // (earliest cycle, index)
+    std::array<std::priority_queue<ReadyEntry>, pipeline_class_count> ready;
+    std::priority_queue<WaitingEntry, std::vector<WaitingEntry>, std::greater<>> waiting;
+    std::size_t ready_count = 0;
+
+    for(int idx = 0; idx < node_count; ++idx) {
+        remaining[idx] = nodes_[idx].predecessors;
+        if (remaining[idx] == 0) {
+            waiting.emplace(0, idx);
+        }
+    }
+
+    int cycle = 0;
+    while(static_cast<int>(order.size()) < node_count) {
+        while(!waiting.empty() && waiting.top().first <= cycle) {
+            int curr_idx = waiting.top().second;
+            waiting.pop();
+            ready[static_cast<std::size_t>(nodes_[curr_idx].pipeline)].emplace(nodes_[curr_idx].height, -curr_idx);
+            ++ready_count;
+        }
+        if (ready_count == 0) {
+            cycle = waiting.top().first;
+            continue;
+        }
+
+        std::array<int, pipeline_class_count> used{};
+        for(int issued = 0; issued < model.issue_width; ++issued) {
+            std::size_t best = pipeline_class_count;
+            for(std::size_t curr_class = 0; curr_class < pipeline_class_count; ++curr_class) {
+                if (ready[curr_class].empty() || used[curr_class] >= model.units[curr_class]) {
+                    continue;
+                }
+                if (best == pipeline_class_count || ready[best].top() < ready[curr_class].top()) {
+                    best = curr_class;
+                }
+            }
+            if (best == pipeline_class_count) {
+                break;
+            }
+
+            int curr_idx = -ready[best].top().second;
+            ready[best].pop();
+            --ready_count;
+            ++used[best];
+            order.push_back(curr_idx);
+
+            for(const auto& curr_edge: nodes_[curr_idx].successors) {
+                earliest[curr_edge.to] = std::max(earliest[curr_edge.to], cycle + curr_edge.latency);
+                if (--remaining[curr_edge.to] == 0) {
+                    waiting.emplace(earliest[curr_edge.to], curr_edge.to);
+                }
+            }
+        }
+        ++cycle;
+    }
+
+    return order;
+}
+
+int AssemblerPassScheduler::estimate_cycles_(const std::vector<int>& order) const {
+    // In-order issue: each instruction waits for its operands and for room in the cycle.
+    std::vector<int> ready_at(nodes_.size(), 0);
+    std::array<int, pipeline_class_count> used{};
+    int cycle = 0;
+    int issued = 0;
+    int finish = 0;
+
+    for(int curr_idx: order) {
+        const auto& curr_node = nodes_[curr_idx];
+        auto pipeline = static_cast<std::size_t>(curr_node.pipeline);
+        int start = std::max(cycle, ready_at[curr_idx]);
+        if (start > cycle || issued >= model.issue_width || used[pipeline] >= model.units[pipeline]) {
+            cycle = std::max(start, cycle + 1);
+            issued = 0;
+            used = {};
+        }
+        ++issued;
+        ++used[pipeline];
+
+        finish = std::max(finish, cycle + model.latency_of(curr_node.pipeline));
+        for(const auto& curr_edge: curr_node.successors) {
+            ready_at[curr_edge.to] = std::max(ready_at[curr_edge.to], cycle + curr_edge.latency);
+        }
+    }
+
+    return finish;
+}
+
+} // namespace billiec::codegen
@@ -1,57 +1,45 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #include <codegen/AssemblyGenerator.h>
 
+#include <core/Trace.h>
+
 namespace billiec::codegen {
-std::vector<std::unique_ptr<AssemblerNode>> AssemblyGenerator::generate_assembly() {
-    instructions.clear();
+MachineProgram AssemblyGenerator::generate_assembly() {
+    program.functions.clear();
     
-    auto curr_node = program_node->accept(*this);
-    instructions.push_back(std::move(curr_node));
+    program_node->accept(*this);
     
-    return std::move(instructions);
+    return std::move(program);
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const ProgramTackyNode& node) {
-    return ProgramAssemblerNode::create(node.function_definition->accept(*this));
+void AssemblyGenerator::visit(const ProgramTackyNode& node) {
+    node.function_definition->accept(*this);
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const FunctionTackyNode& node) {
-    std::vector<std::unique_ptr<AssemblerNode>> instructions;
+void AssemblyGenerator::visit(const FunctionTackyNode& node) {
+    TraceSpan span{"function", node.name.lexeme};
     
-    for(const auto& curr_node: node.instructions) {
-        instructions.push_back(curr_node->accept(*this));
-    }
+    // The whole body goes through selection at once so patterns can span several instructions.
+    selector_.select(node.instructions);
+    selector_.function.name = node.name.lexeme;
     
-    return FunctionAssemblerNode::create(node.name, std::move(instructions));
+    program.functions.push_back(std::move(selector_.function));
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const ReturnTackyNode& node) {    
-    std::vector<AssemblerNode::PtrType> instructions;
-    instructions.push_back(node.return_expr->accept(*this));
-    instructions.push_back(ReturnInstructionNode::create());
-    
-    return CompoundAssemblerNode::create(std::move(instructions));
+// Instructions and their operands never get here, the selector takes the function body whole.
+void AssemblyGenerator::visit(const ReturnTackyNode&) {
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const UnaryTackyNode& node) {
-    auto src = node.src->accept(*this);
-    auto dst = node.dst->accept(*this);
-    
-    auto mov = MovInstructionNode::create(std::move(src), std::move(dst));
-    auto unary = UnaryInstructionNode::create(UnaryInstructionNode::Operator::Not, node.dst->accept(*this));
-    
-    std::vector<AssemblerNode::PtrType> instructions;
-    instructions.push_back(std::move(mov));
-    instructions.push_back(std::move(unary));
-    
-    return CompoundAssemblerNode::create(std::move(instructions));
+void AssemblyGenerator::visit(const UnaryTackyNode&) {
+}
+
+void AssemblyGenerator::visit(const BinaryTackyNode&) {
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const IntConstTackyNode& node) {
-    return LiteralInstructionNode::create(node.value);
+void AssemblyGenerator::visit(const IntConstTackyNode&) {
 }
 
-std::unique_ptr<AssemblerNode> AssemblyGenerator::visit(const VarTackyNode& node) {
-    return PseudoRegister::create(node.var_name);
+void AssemblyGenerator::visit(const VarTackyNode&) {
 }
+
 } // namespace billiec::codegen
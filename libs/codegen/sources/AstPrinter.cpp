@@ -5,6 +5,9 @@
 
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 namespace billiec::codegen {
 
@@ -56,9 +59,43 @@ std::string AstPrinter::visit(const parser::ReturnNode& node) {
 }
 
 std::string AstPrinter::visit(const parser::UnaryNode& node) {
+    return print_expression_(node);
+}
+
+std::string AstPrinter::visit(const parser::BinaryNode& node) {
+    return print_expression_(node);
+}
+
+// Prints in order from a worklist of nodes and literal text, nesting can be deeper than the stack.
+std::string AstPrinter::print_expression_(const parser::AstNode& root) {
+    using Item = std::variant<const parser::AstNode*, std::string_view>;
+    std::vector<Item> work{&root};
     std::stringstream stream;
     
-    stream << node.operation.lexeme << accept(*this, node.expr);
+    while(!work.empty()) {
+        auto item = work.back();
+        work.pop_back();
+        if (auto text = std::get_if<std::string_view>(&item)) {
+            stream << *text;
+            continue;
+        }
+        
+        const auto* node = std::get<const parser::AstNode*>(item);
+        if (auto unary = dynamic_cast<const parser::UnaryNode*>(node)) {
+            work.push_back(unary->expr.get());
+            work.push_back(std::string_view{unary->operation.lexeme});
+        } else if (auto binary = dynamic_cast<const parser::BinaryNode*>(node)) {
+            work.push_back(std::string_view{")"});
+            work.push_back(binary->right.get());
+            work.push_back(std::string_view{" "});
+            work.push_back(std::string_view{binary->operation.lexeme});
+            work.push_back(std::string_view{" "});
+            work.push_back(binary->left.get());
+            work.push_back(std::string_view{"("});
+        } else {
+            stream << visit(dynamic_cast<const parser::LiteralNode&>(*node));
+        }
+    }
     
     return stream.str();
 }
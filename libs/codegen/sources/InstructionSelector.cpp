@@ -0,0 +1,828 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/InstructionSelector.h>
+
+#include <codegen/AssemblerOperands.h>
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace billiec::codegen {
+
+namespace {
+
+using Op = SelectionOperator;
+using Nt = Nonterminal;
+constexpr int no_match = std::numeric_limits<int>::max() / 4;
+
+constexpr int arity(Op op) {
+    switch(op) {
+        case Op::Const:
+        case Op::Var:
+            return 0;
+        case Op::Neg:
+        case Op::Not:
+        case Op::Ret:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+/** @brief  One entry of a pattern written out in pre-order, either an operator or a nonterminal leaf. */
+struct PatternItem {
+    Op op{Op::count};
+    Nt leaf{Nt::count};
+
+    constexpr bool is_leaf() const {
+        return op == Op::count;
+    }
+};
+
+constexpr PatternItem op(Op which) {
+    return PatternItem{.op = which};
+}
+
+constexpr PatternItem nt(Nt which) {
+    return PatternItem{.leaf = which};
+}
+
+/** @brief  How a matched rule turns into instructions. */
+enum class Emit {
+    fold,               ///< Constant, no code.
+    immediate,          ///< Constant used as an immediate operand.
+    load_immediate,     ///< Constant moved into a register.
+    var,                ///< Already in its pseudo-register.
+    neg,
+    mvn,
+    add,
+    sub,
+    add_negated,        ///< add/sub with the immediate negated.
+    sub_negated,
+    add_one,
+    sub_one,
+    add_shifted,
+    sub_shifted,
+    madd,
+    msub,
+    mul,
+    copy,               ///< The operand itself, no code.
+    mul_pow2,           ///< lsl.
+    mul_pow2_plus1,     ///< add of the operand shifted.
+    mul_pow2_minus1,    ///< lsl then sub.
+    sdiv,
+    div_constant,       ///< Shifts for powers of two, a magic-number multiply otherwise.
+    mod,                ///< sdiv then msub.
+    mod_constant,       ///< The quotient as div_constant, then the remainder from it.
+    zero_result,        ///< x * 0, x % 1 and x % -1.
+    ret
+};
+
+/** @brief  A rule: \c result can be produced from \c pattern for \c cost more instructions.
+ *
+ * \c operands picks which of the pattern's leaves, numbered in pre-order, feed the instruction
+ * and in what order.  \c accepts restricts chain rules from \c con to the values they encode.
+ */
+struct SelectionRule {
+    Nt result;
+    std::array<PatternItem, 5> pattern;
+    int cost;
+    Emit emit;
+    std::array<int, 3> operands{0, 1, 2};
+    bool (*accepts)(int value){nullptr};
+};
+
+constexpr bool is_imm12(int value) {
+    return value >= 0 && value <= 4095;
+}
+
+constexpr bool is_negated_imm12(int value) {
+    return value < 0 && value >= -4095;
+}
+
+constexpr bool is_pow2(int value) {
+    return value > 1 && std::has_single_bit(static_cast<std::uint32_t>(value));
+}
+
+constexpr bool is_zero(int value) {
+    return value == 0;
+}
+
+constexpr bool is_one(int value) {
+    return value == 1;
+}
+
+constexpr bool is_minus_one(int value) {
+    return value == -1;
+}
+
+constexpr bool is_pow2_plus1(int value) {
+    return value > 2 && is_pow2(value - 1);
+}
+
+constexpr bool is_pow2_minus1(int value) {
+    return value > 2 && std::has_single_bit(static_cast<std::uint32_t>(value) + 1u);
+}
+
+constexpr bool is_negated_pow2(int value) {
+    return value < -1 && value != std::numeric_limits<int>::min() && is_pow2(-value);
+}
+
+// INT_MIN is left to sdiv, it's the one divisor whose magic number doesn't fit.
+constexpr bool is_magic_divisor(int value) {
+    return value != 0 && value != 1 && value != -1 && value != std::numeric_limits<int>::min() &&
+           !std::has_single_bit(static_cast<std::uint32_t>(value < 0 ? -value : value));
+}
+
+bool fits_mov(int value) {
+    return fits_mov_immediate(value);
+}
+
+bool needs_movk(int value) {
+    return !fits_mov_immediate(value);
+}
+
+// Costs count instructions, except that sdiv counts for the dozen or so cycles it takes, so a
+// division by a constant goes to the handful of shifts and multiplies that stand in for it.
+constexpr std::array selection_rules = {
+    // Constants fold for free, and come in as immediates where the instruction has room for one.
+    SelectionRule{Nt::con,    {op(Op::Const)},                                        0, Emit::fold},
+    SelectionRule{Nt::con,    {op(Op::Neg), nt(Nt::con)},                             0, Emit::fold},
+    SelectionRule{Nt::con,    {op(Op::Not), nt(Nt::con)},                             0, Emit::fold},
+    SelectionRule{Nt::con,    {op(Op::Add), nt(Nt::con), nt(Nt::con)},                0, Emit::fold},
+    SelectionRule{Nt::con,    {op(Op::Sub), nt(Nt::con), nt(Nt::con)},                0, Emit::fold},
+    SelectionRule{Nt::con,    {op(Op::Mul), nt(Nt::con), nt(Nt::con)},                0, Emit::fold},
+    SelectionRule{Nt::imm12,  {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_imm12},
+    SelectionRule{Nt::nimm12, {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_negated_imm12},
+    SelectionRule{Nt::pow2,   {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_pow2},
+    SelectionRule{Nt::zero,   {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_zero},
+    SelectionRule{Nt::one,    {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_one},
+    SelectionRule{Nt::minus_one, {nt(Nt::con)},                                       0, Emit::immediate, {}, &is_minus_one},
+    SelectionRule{Nt::pow2_plus1, {nt(Nt::con)},                                      0, Emit::immediate, {}, &is_pow2_plus1},
+    SelectionRule{Nt::pow2_minus1, {nt(Nt::con)},                                     0, Emit::immediate, {}, &is_pow2_minus1},
+    SelectionRule{Nt::npow2,  {nt(Nt::con)},                                          0, Emit::immediate, {}, &is_negated_pow2},
+    SelectionRule{Nt::divisor, {nt(Nt::con)},                                         0, Emit::immediate, {}, &is_magic_divisor},
+    SelectionRule{Nt::reg,    {nt(Nt::con)},                                          1, Emit::load_immediate, {}, &fits_mov},
+    SelectionRule{Nt::reg,    {nt(Nt::con)},                                          2, Emit::load_immediate, {}, &needs_movk},
+    SelectionRule{Nt::reg,    {op(Op::Var)},                                          0, Emit::var},
+
+    // -(~x) is x + 1 and ~(-x) is x - 1.
+    SelectionRule{Nt::reg,    {op(Op::Neg), nt(Nt::reg)},                             1, Emit::neg},
+    SelectionRule{Nt::reg,    {op(Op::Not), nt(Nt::reg)},                             1, Emit::mvn},
+    SelectionRule{Nt::reg,    {op(Op::Neg), op(Op::Not), nt(Nt::reg)},                1, Emit::add_one},
+    SelectionRule{Nt::reg,    {op(Op::Not), op(Op::Neg), nt(Nt::reg)},                1, Emit::sub_one},
+
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), nt(Nt::reg)},                1, Emit::add},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), nt(Nt::imm12)},              1, Emit::add},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::imm12), nt(Nt::reg)},              1, Emit::add, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), nt(Nt::nimm12)},             1, Emit::sub_negated},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::nimm12), nt(Nt::reg)},             1, Emit::sub_negated, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), op(Op::Neg), nt(Nt::reg)},  1, Emit::sub},
+    SelectionRule{Nt::reg,    {op(Op::Add), op(Op::Neg), nt(Nt::reg), nt(Nt::reg)},  1, Emit::sub, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), op(Op::Mul), nt(Nt::reg), nt(Nt::reg)},   1, Emit::madd, {1, 2, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Add), op(Op::Mul), nt(Nt::reg), nt(Nt::reg), nt(Nt::reg)},   1, Emit::madd, {0, 1, 2}},
+    SelectionRule{Nt::reg,    {op(Op::Add), nt(Nt::reg), op(Op::Mul), nt(Nt::reg), nt(Nt::pow2)},  1, Emit::add_shifted, {0, 1, 2}},
+    SelectionRule{Nt::reg,    {op(Op::Add), op(Op::Mul), nt(Nt::reg), nt(Nt::pow2), nt(Nt::reg)},  1, Emit::add_shifted, {2, 0, 1}},
+
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), nt(Nt::reg)},                1, Emit::sub},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), nt(Nt::imm12)},              1, Emit::sub},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), nt(Nt::nimm12)},             1, Emit::add_negated},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::zero), nt(Nt::reg)},               1, Emit::neg, {1}},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), op(Op::Neg), nt(Nt::reg)},  1, Emit::add},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), op(Op::Mul), nt(Nt::reg), nt(Nt::reg)},   1, Emit::msub, {1, 2, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Sub), nt(Nt::reg), op(Op::Mul), nt(Nt::reg), nt(Nt::pow2)},  1, Emit::sub_shifted, {0, 1, 2}},
+
+    // Constant multipliers that are a shift or two away, ahead of mul so they win a tie with it.
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::zero)},               1, Emit::zero_result},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::zero), nt(Nt::reg)},               1, Emit::zero_result, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::one)},                0, Emit::copy},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::one), nt(Nt::reg)},                0, Emit::copy, {1}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::minus_one)},          1, Emit::neg},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::minus_one), nt(Nt::reg)},          1, Emit::neg, {1}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::pow2)},               1, Emit::mul_pow2},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::pow2), nt(Nt::reg)},               1, Emit::mul_pow2, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::pow2_plus1)},         1, Emit::mul_pow2_plus1},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::pow2_plus1), nt(Nt::reg)},         1, Emit::mul_pow2_plus1, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::pow2_minus1)},        2, Emit::mul_pow2_minus1},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::pow2_minus1), nt(Nt::reg)},        2, Emit::mul_pow2_minus1, {1, 0}},
+    SelectionRule{Nt::reg,    {op(Op::Mul), nt(Nt::reg), nt(Nt::reg)},                1, Emit::mul},
+
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::one)},                0, Emit::copy},
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::minus_one)},          1, Emit::neg},
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::pow2)},               3, Emit::div_constant},
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::npow2)},              4, Emit::div_constant},
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::divisor)},            5, Emit::div_constant},
+    SelectionRule{Nt::reg,    {op(Op::Div), nt(Nt::reg), nt(Nt::reg)},                8, Emit::sdiv},
+
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::one)},                1, Emit::zero_result},
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::minus_one)},          1, Emit::zero_result},
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::pow2)},               4, Emit::mod_constant},
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::npow2)},              4, Emit::mod_constant},
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::divisor)},            7, Emit::mod_constant},
+    SelectionRule{Nt::reg,    {op(Op::Mod), nt(Nt::reg), nt(Nt::reg)},                9, Emit::mod},
+
+    SelectionRule{Nt::stmt,   {op(Op::Ret), nt(Nt::reg)},                             1, Emit::ret},
+};
+
+constexpr std::size_t max_rules_per_entry = 16;
+
+/** @brief  Rule numbers sharing a root, so labeling a node only looks at rules that can match it. */
+struct RuleIndex {
+    std::array<int, max_rules_per_entry> rules{};
+    std::size_t count{0};
+
+    constexpr void add(int rule) {
+        rules[count++] = rule;
+    }
+};
+
+// Rules rooted at each operator, and chain rules keyed by the nonterminal they start from.
+constexpr auto rules_by_operator = [] {
+    std::array<RuleIndex, selection_operator_count> index{};
+    for(std::size_t idx = 0; idx < selection_rules.size(); ++idx) {
+        const auto& root = selection_rules[idx].pattern[0];
+        if (!root.is_leaf()) {
+            index[static_cast<std::size_t>(root.op)].add(static_cast<int>(idx));
+        }
+    }
+    return index;
+}();
+
+constexpr auto chain_rules = [] {
+    std::array<RuleIndex, nonterminal_count> index{};
+    for(std::size_t idx = 0; idx < selection_rules.size(); ++idx) {
+        const auto& root = selection_rules[idx].pattern[0];
+        if (root.is_leaf()) {
+            index[static_cast<std::size_t>(root.leaf)].add(static_cast<int>(idx));
+        }
+    }
+    return index;
+}();
+
+static_assert(rules_by_operator[static_cast<std::size_t>(Op::Add)].count < max_rules_per_entry);
+static_assert(rules_by_operator[static_cast<std::size_t>(Op::Mul)].count < max_rules_per_entry);
+static_assert(chain_rules[static_cast<std::size_t>(Nt::con)].count < max_rules_per_entry);
+
+std::optional<Op> operator_of(const scanner::Token& token, bool unary) {
+    switch(token.token_type) {
+        case scanner::TokenType::MINUS:
+            return unary ? Op::Neg : Op::Sub;
+        case scanner::TokenType::COMPLEMENT:
+            return Op::Not;
+        case scanner::TokenType::PLUS:
+            return Op::Add;
+        case scanner::TokenType::STAR:
+            return Op::Mul;
+        case scanner::TokenType::SLASH:
+            return Op::Div;
+        case scanner::TokenType::PERCENT:
+            return Op::Mod;
+        default:
+            return std::nullopt;
+    }
+}
+
+} // namespace
+
+// Hacker's Delight figure 10-1: the smallest shift whose multiplier is exact for every 32-bit n.
+DivisionMagic signed_division_magic(int divisor) {
+    constexpr std::uint32_t two31 = 0x80000000u;
+    auto d = static_cast<std::uint32_t>(divisor);
+    std::uint32_t ad = divisor < 0 ? 0u - d : d;
+    std::uint32_t t = two31 + (d >> 31);
+    std::uint32_t anc = t - 1 - t % ad;      // |nc|, the largest n with n % |d| == |d| - 1.
+    std::uint32_t q1 = two31 / anc;
+    std::uint32_t r1 = two31 - q1 * anc;
+    std::uint32_t q2 = two31 / ad;
+    std::uint32_t r2 = two31 - q2 * ad;
+    int p = 31;
+    std::uint32_t delta = 0;
+    do {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            ++q1;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            ++q2;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while(q1 < delta || (q1 == delta && r1 == 0));
+    
+    auto multiplier = q2 + 1;
+    return DivisionMagic{
+        .multiplier = static_cast<int>(divisor < 0 ? 0u - multiplier : multiplier),
+        .shift = p - 32
+    };
+}
+
+void InstructionSelector::select(const std::vector<TackyNode::PtrType>& tacky_instructions) {
+    reset_();
+    for(const auto& curr_ins: tacky_instructions) {
+        count_operands_(*curr_ins);
+    }
+    for(const auto& curr_ins: tacky_instructions) {
+        add_instruction_(*curr_ins);
+    }
+    reduce_roots_();
+}
+
+void InstructionSelector::reset_() {
+    function = MachineFunction{};
+    pseudo_idx_.clear();
+    nodes_.clear();
+    roots_.clear();
+    uses_.clear();
+    defs_.clear();
+    pending_.clear();
+}
+
+void InstructionSelector::count_operands_(const TackyNode& tacky_instruction) {
+    auto count_use = [this](const TackyNode& operand) {
+        if (auto var = dynamic_cast<const VarTackyNode*>(&operand)) {
+            ++uses_[var->var_name];
+        }
+    };
+
+    if (auto node = dynamic_cast<const UnaryTackyNode*>(&tacky_instruction)) {
+        count_use(*node->src);
+        ++defs_[dynamic_cast<const VarTackyNode&>(*node->dst).var_name];
+    } else if (auto node = dynamic_cast<const BinaryTackyNode*>(&tacky_instruction)) {
+        count_use(*node->src1);
+        count_use(*node->src2);
+        ++defs_[dynamic_cast<const VarTackyNode&>(*node->dst).var_name];
+    } else if (auto node = dynamic_cast<const ReturnTackyNode*>(&tacky_instruction)) {
+        count_use(*node->return_expr);
+    }
+}
+
+void InstructionSelector::add_instruction_(const TackyNode& tacky_instruction) {
+    if (auto node = dynamic_cast<const UnaryTackyNode*>(&tacky_instruction)) {
+        int src = add_operand_(*node->src);
+        int idx = add_node_(*operator_of(node->operation, true), {src, -1}, {});
+        define_(idx, dynamic_cast<const VarTackyNode&>(*node->dst).var_name);
+    } else if (auto node = dynamic_cast<const BinaryTackyNode*>(&tacky_instruction)) {
+        int src1 = add_operand_(*node->src1);
+        int src2 = add_operand_(*node->src2);
+        int idx = add_node_(*operator_of(node->operation, false), {src1, src2}, {});
+        define_(idx, dynamic_cast<const VarTackyNode&>(*node->dst).var_name);
+    } else if (auto node = dynamic_cast<const ReturnTackyNode*>(&tacky_instruction)) {
+        int expr = add_operand_(*node->return_expr);
+        int idx = add_node_(Op::Ret, {expr, -1}, {});
+        label_(idx);
+        roots_.push_back(idx);
+    }
+}
+
+int InstructionSelector::add_operand_(const TackyNode& operand) {
+    if (auto constant = dynamic_cast<const IntConstTackyNode*>(&operand)) {
+        int idx = add_node_(Op::Const, {-1, -1}, {});
+        nodes_[idx].value = constant->value;
+        label_(idx);
+        return idx;
+    }
+
+    const auto& var_name = dynamic_cast<const VarTackyNode&>(operand).var_name;
+    if (auto itr = pending_.find(var_name); itr != pending_.end()) {
+        int idx = itr->second;
+        pending_.erase(itr);
+        return idx;
+    }
+
+    int idx = add_node_(Op::Var, {-1, -1}, var_name);
+    nodes_[idx].stable = defs_[var_name] <= 1;
+    label_(idx);
+    return idx;
+}
+
+int InstructionSelector::add_node_(SelectionOperator op, std::array<int, 2> kids, std::string name) {
+    Node node;
+    node.op = op;
+    node.kids = kids;
+    node.name = std::move(name);
+    for(int curr_kid: kids) {
+        if (curr_kid >= 0) {
+            node.stable = node.stable && nodes_[curr_kid].stable;
+        }
+    }
+    nodes_.push_back(std::move(node));
+    return static_cast<int>(nodes_.size()) - 1;
+}
+
+void InstructionSelector::define_(int node, const std::string& dst) {
+    nodes_[node].name = dst;
+    label_(node);
+
+    // Moving the computation down to its only reader is fine as long as nothing it reads can be
+    // written in between.
+    if (uses_[dst] == 1 && defs_[dst] == 1 && nodes_[node].stable) {
+        pending_[dst] = node;
+    } else {
+        roots_.push_back(node);
+    }
+}
+
+void InstructionSelector::label_(int node) {
+    auto& curr_node = nodes_[node];
+    curr_node.cost.fill(no_match);
+    curr_node.rule.fill(-1);
+
+    const auto& candidates = rules_by_operator[static_cast<std::size_t>(curr_node.op)];
+    for(std::size_t idx = 0; idx < candidates.count; ++idx) {
+        int rule_idx = candidates.rules[idx];
+        const auto& rule = selection_rules[rule_idx];
+        std::size_t pos = 0;
+        int cost = match_(node, rule_idx, pos);
+        if (cost >= no_match) {
+            continue;
+        }
+
+        auto result = static_cast<std::size_t>(rule.result);
+        if (cost + rule.cost < curr_node.cost[result]) {
+            curr_node.cost[result] = cost + rule.cost;
+            curr_node.rule[result] = rule_idx;
+            if (rule.emit == Emit::fold) {
+                curr_node.value = fold_(curr_node);
+            }
+        }
+    }
+
+    // Chain rules until nothing gets cheaper, there are few enough that a couple of rounds do it.
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(std::size_t from = 0; from < nonterminal_count; ++from) {
+            if (curr_node.cost[from] >= no_match) {
+                continue;
+            }
+            const auto& chains = chain_rules[from];
+            for(std::size_t idx = 0; idx < chains.count; ++idx) {
+                const auto& rule = selection_rules[chains.rules[idx]];
+                if (rule.accepts != nullptr && !rule.accepts(curr_node.value)) {
+                    continue;
+                }
+                auto result = static_cast<std::size_t>(rule.result);
+                if (curr_node.cost[from] + rule.cost < curr_node.cost[result]) {
+                    curr_node.cost[result] = curr_node.cost[from] + rule.cost;
+                    curr_node.rule[result] = chains.rules[idx];
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+// Cost of the leaves the rule's pattern binds below node, or no_match.
+int InstructionSelector::match_(int node, int rule, std::size_t& pos) const {
+    const auto& item = selection_rules[rule].pattern[pos++];
+    const auto& curr_node = nodes_[node];
+    if (item.is_leaf()) {
+        return curr_node.cost[static_cast<std::size_t>(item.leaf)];
+    }
+    if (item.op != curr_node.op) {
+        return no_match;
+    }
+
+    int cost = 0;
+    for(int kid_idx = 0; kid_idx < arity(item.op); ++kid_idx) {
+        cost += match_(curr_node.kids[kid_idx], rule, pos);
+        if (cost >= no_match) {
+            return no_match;
+        }
+    }
+    return cost;
+}
+
+void InstructionSelector::bind_(int node, int rule, std::size_t& pos, std::vector<Binding>& bindings) const {
+    const auto& item = selection_rules[rule].pattern[pos++];
+    if (item.is_leaf()) {
+        bindings.push_back(Binding{.node = node, .nonterminal = item.leaf});
+        return;
+    }
+    for(int kid_idx = 0; kid_idx < arity(item.op); ++kid_idx) {
+        bind_(nodes_[node].kids[kid_idx], rule, pos, bindings);
+    }
+}
+
+int InstructionSelector::fold_(const Node& node) const {
+    // Wraps the way the hardware would.
+    auto kid = [this, &node](int idx) {
+        return static_cast<std::uint32_t>(nodes_[node.kids[idx]].value);
+    };
+    switch(node.op) {
+        case Op::Neg:
+            return static_cast<int>(0u - kid(0));
+        case Op::Not:
+            return static_cast<int>(~kid(0));
+        case Op::Add:
+            return static_cast<int>(kid(0) + kid(1));
+        case Op::Sub:
+            return static_cast<int>(kid(0) - kid(1));
+        case Op::Mul:
+            return static_cast<int>(kid(0) * kid(1));
+        default:
+            return node.value;
+    }
+}
+
+void InstructionSelector::reduce_roots_() {
+    for(int curr_root: roots_) {
+        const auto& root = nodes_[curr_root];
+        if (root.op == Op::Ret) {
+            reduce_(curr_root, Nt::stmt, nullptr);
+            continue;
+        }
+
+        auto dst = pseudo_(root.name);
+        auto value = reduce_(curr_root, Nt::reg, &dst);
+        if (value != dst) {
+            emit_(MachineInstruction::create(Opcode::mov, {dst, value}));
+        }
+    }
+}
+
+// Emits the code for node as nonterminal and returns the operand holding the result.  When dst
+// is given the result should go there, though leaves that already live somewhere stay put.
+// Trees are as deep as the expressions they came from, so the leaves of each rule are reduced
+// from an explicit stack of frames rather than by recursing.
+MachineOperand InstructionSelector::reduce_(int node, Nonterminal nonterminal, const MachineOperand* dst) {
+    struct Frame {
+        int node{0};
+        int rule_idx{0};
+        std::optional<MachineOperand> dst{};
+        std::vector<Binding> bindings{};
+        std::array<MachineOperand, 3> leaves{};
+        std::size_t next_leaf{0};
+    };
+    std::vector<Frame> frames;
+    
+    // Rules without leaves are done on the spot, the rest get a frame.
+    auto start = [this, &frames](int node, Nonterminal nonterminal, const MachineOperand* dst) -> std::optional<MachineOperand> {
+        int rule_idx = nodes_[node].rule[static_cast<std::size_t>(nonterminal)];
+        if (auto operand = reduce_leaf_(node, rule_idx, dst)) {
+            return operand;
+        }
+        Frame frame{.node = node, .rule_idx = rule_idx};
+        if (dst != nullptr) {
+            frame.dst = *dst;
+        }
+        std::size_t pos = 0;
+        bind_(node, rule_idx, pos, frame.bindings);
+        frames.push_back(std::move(frame));
+        return std::nullopt;
+    };
+    
+    if (auto operand = start(node, nonterminal, dst)) {
+        return *operand;
+    }
+    
+    // Returns compute straight into w0 where they can.
+    auto w0 = MachineOperand::reg(Register::W0);
+    while(true) {
+        auto& frame = frames.back();
+        if (frame.next_leaf < frame.bindings.size()) {
+            auto binding = frame.bindings[frame.next_leaf];
+            bool is_ret = selection_rules[frame.rule_idx].emit == Emit::ret;
+            if (auto operand = start(binding.node, binding.nonterminal, is_ret ? &w0 : nullptr)) {
+                // start only pushes a frame when it hands back nothing, so frame is still good here.
+                frame.leaves[frame.next_leaf++] = *operand;
+            }
+            continue;
+        }
+        
+        auto operand = emit_rule_(frame.node, frame.rule_idx, frame.leaves, frame.dst ? &*frame.dst : nullptr);
+        frames.pop_back();
+        if (frames.empty()) {
+            return operand;
+        }
+        frames.back().leaves[frames.back().next_leaf++] = operand;
+    }
+}
+
+std::optional<MachineOperand> InstructionSelector::reduce_leaf_(int node, int rule_idx, const MachineOperand* dst) {
+    const auto& curr_node = nodes_[node];
+    switch(selection_rules[rule_idx].emit) {
+        case Emit::immediate:
+            return MachineOperand::imm(curr_node.value);
+        case Emit::load_immediate: {
+            auto target = destination_(node, dst);
+            emit_(MachineInstruction::create(Opcode::mov, {target, MachineOperand::imm(curr_node.value)}));
+            return target;
+        }
+        case Emit::var:
+            return pseudo_(curr_node.name);
+        default:
+            return std::nullopt;
+    }
+}
+
+// The instruction for a rule once its leaves are in registers or immediates.
+MachineOperand InstructionSelector::emit_rule_(int node, int rule_idx, const std::array<MachineOperand, 3>& leaves,
+                                               const MachineOperand* dst) {
+    const auto& rule = selection_rules[rule_idx];
+    auto w0 = MachineOperand::reg(Register::W0);
+    auto operand = [&](std::size_t idx) {
+        return leaves[rule.operands[idx]];
+    };
+    
+    if (rule.emit == Emit::ret) {
+        if (operand(0) != w0) {
+            emit_(MachineInstruction::create(Opcode::mov, {w0, operand(0)}));
+        }
+        emit_(MachineInstruction::create(Opcode::ret));
+        return {};
+    }
+
+    auto target = destination_(node, dst);
+    switch(rule.emit) {
+        case Emit::neg:
+            emit_(MachineInstruction::create(Opcode::neg, {target, operand(0)}));
+            break;
+        case Emit::mvn:
+            emit_(MachineInstruction::create(Opcode::mvn, {target, operand(0)}));
+            break;
+        case Emit::add:
+            emit_(MachineInstruction::create(Opcode::add, {target, operand(0), operand(1)}));
+            break;
+        case Emit::sub:
+            emit_(MachineInstruction::create(Opcode::sub, {target, operand(0), operand(1)}));
+            break;
+        case Emit::add_negated:
+        case Emit::sub_negated: {
+            auto rhs = MachineOperand::imm(-operand(1).value);
+            auto which = rule.emit == Emit::add_negated ? Opcode::add : Opcode::sub;
+            emit_(MachineInstruction::create(which, {target, operand(0), rhs}));
+            break;
+        }
+        case Emit::add_one:
+        case Emit::sub_one: {
+            auto which = rule.emit == Emit::add_one ? Opcode::add : Opcode::sub;
+            emit_(MachineInstruction::create(which, {target, operand(0), MachineOperand::imm(1)}));
+            break;
+        }
+        case Emit::add_shifted:
+        case Emit::sub_shifted: {
+            int shift = std::countr_zero(static_cast<std::uint32_t>(operand(2).value));
+            auto which = rule.emit == Emit::add_shifted ? Opcode::add : Opcode::sub;
+            emit_(MachineInstruction::create(which, {target, operand(0), operand(1)}, shift));
+            break;
+        }
+        case Emit::madd:
+        case Emit::msub: {
+            auto which = rule.emit == Emit::madd ? Opcode::madd : Opcode::msub;
+            emit_(MachineInstruction::create(which, {target, operand(0), operand(1), operand(2)}));
+            break;
+        }
+        case Emit::mul:
+            emit_(MachineInstruction::create(Opcode::mul, {target, operand(0), operand(1)}));
+            break;
+        case Emit::copy:
+            return operand(0);
+        case Emit::mul_pow2: {
+            int shift = std::countr_zero(static_cast<std::uint32_t>(operand(1).value));
+            emit_(MachineInstruction::create(Opcode::lsl, {target, operand(0)}, shift));
+            break;
+        }
+        case Emit::mul_pow2_plus1: {
+            // x * (2^k + 1) is x + (x << k).
+            int shift = std::countr_zero(static_cast<std::uint32_t>(operand(1).value) - 1u);
+            emit_(MachineInstruction::create(Opcode::add, {target, operand(0), operand(0)}, shift));
+            break;
+        }
+        case Emit::mul_pow2_minus1: {
+            // x * (2^k - 1) is (x << k) - x.
+            int shift = std::countr_zero(static_cast<std::uint32_t>(operand(1).value) + 1u);
+            auto shifted = pseudo_(generate_temp_name_());
+            emit_(MachineInstruction::create(Opcode::lsl, {shifted, operand(0)}, shift));
+            emit_(MachineInstruction::create(Opcode::sub, {target, shifted, operand(0)}));
+            break;
+        }
+        case Emit::div_constant:
+            emit_quotient_(operand(0), operand(1).value, target);
+            break;
+        case Emit::mod_constant: {
+            // The remainder takes the dividend's sign, so a negated power of two leaves the same one.
+            int divisor = operand(1).value;
+            auto quotient = pseudo_(generate_temp_name_());
+            if (is_pow2(divisor) || is_negated_pow2(divisor)) {
+                int magnitude = divisor < 0 ? -divisor : divisor;
+                emit_quotient_(operand(0), magnitude, quotient);
+                emit_(MachineInstruction::create(Opcode::sub, {target, operand(0), quotient},
+                                                 std::countr_zero(static_cast<std::uint32_t>(magnitude))));
+            } else {
+                auto divisor_register = pseudo_(generate_temp_name_());
+                emit_quotient_(operand(0), divisor, quotient);
+                emit_(MachineInstruction::create(Opcode::mov, {divisor_register, MachineOperand::imm(divisor)}));
+                emit_(MachineInstruction::create(Opcode::msub, {target, quotient, divisor_register, operand(0)}));
+            }
+            break;
+        }
+        case Emit::zero_result:
+            emit_(MachineInstruction::create(Opcode::mov, {target, MachineOperand::imm(0)}));
+            break;
+        case Emit::sdiv:
+            emit_(MachineInstruction::create(Opcode::sdiv, {target, operand(0), operand(1)}));
+            break;
+        case Emit::mod: {
+            // a % b is a - (a / b) * b.
+            auto quotient = pseudo_(generate_temp_name_());
+            emit_(MachineInstruction::create(Opcode::sdiv, {quotient, operand(0), operand(1)}));
+            emit_(MachineInstruction::create(Opcode::msub, {target, quotient, operand(1), operand(0)}));
+            break;
+        }
+        default:
+            break;
+    }
+    return target;
+}
+
+// dividend / divisor rounded toward zero into target.  Only target is written besides fresh
+// temporaries, so target may be the dividend's own register.
+void InstructionSelector::emit_quotient_(MachineOperand dividend, int divisor, MachineOperand target) {
+    int magnitude = divisor < 0 ? -divisor : divisor;
+    if (is_pow2(magnitude)) {
+        // Shifting rounds down, so negative dividends get 2^k - 1 added first: the sign bits
+        // shifted down to the low k bits.
+        int shift = std::countr_zero(static_cast<std::uint32_t>(magnitude));
+        auto biased = pseudo_(generate_temp_name_());
+        if (shift == 1) {
+            emit_(MachineInstruction::create(Opcode::add, {biased, dividend, dividend}, 31, ShiftKind::lsr));
+        } else {
+            auto sign = pseudo_(generate_temp_name_());
+            emit_(MachineInstruction::create(Opcode::asr, {sign, dividend}, 31));
+            emit_(MachineInstruction::create(Opcode::add, {biased, dividend, sign}, 32 - shift, ShiftKind::lsr));
+        }
+        if (divisor > 0) {
+            emit_(MachineInstruction::create(Opcode::asr, {target, biased}, shift));
+        } else {
+            auto quotient = pseudo_(generate_temp_name_());
+            emit_(MachineInstruction::create(Opcode::asr, {quotient, biased}, shift));
+            emit_(MachineInstruction::create(Opcode::neg, {target, quotient}));
+        }
+        return;
+    }
+    
+    auto magic = signed_division_magic(divisor);
+    auto multiplier = pseudo_(generate_temp_name_());
+    auto high = pseudo_(generate_temp_name_());
+    emit_(MachineInstruction::create(Opcode::mov, {multiplier, MachineOperand::imm(magic.multiplier)}));
+    
+    // Without the correction the shift goes into the smull, with it the shift has to wait for it.
+    bool add_dividend = divisor > 0 && magic.multiplier < 0;
+    bool sub_dividend = divisor < 0 && magic.multiplier > 0;
+    auto shifted = high;
+    if (!add_dividend && !sub_dividend) {
+        emit_(MachineInstruction::create(Opcode::smull, {high, dividend, multiplier}, 32 + magic.shift));
+    } else {
+        emit_(MachineInstruction::create(Opcode::smull, {high, dividend, multiplier}, 32));
+        auto corrected = pseudo_(generate_temp_name_());
+        emit_(MachineInstruction::create(add_dividend ? Opcode::add : Opcode::sub, {corrected, high, dividend}));
+        shifted = corrected;
+        if (magic.shift > 0) {
+            shifted = pseudo_(generate_temp_name_());
+            emit_(MachineInstruction::create(Opcode::asr, {shifted, corrected}, magic.shift));
+        }
+    }
+    
+    // Adding the sign bit rounds a negative quotient up to zero.
+    emit_(MachineInstruction::create(Opcode::add, {target, shifted, shifted}, 31, ShiftKind::lsr));
+}
+
+MachineOperand InstructionSelector::destination_(int node, const MachineOperand* dst) {
+    if (dst != nullptr) {
+        return *dst;
+    }
+    if (nodes_[node].name.empty()) {
+        nodes_[node].name = generate_temp_name_();
+    }
+    return pseudo_(nodes_[node].name);
+}
+
+MachineOperand InstructionSelector::pseudo_(const std::string& name) {
+    auto [itr, inserted] = pseudo_idx_.try_emplace(name, static_cast<int>(function.pseudo_registers.size()));
+    if (inserted) {
+        function.pseudo_registers.push_back(PseudoRegisterInfo{.name = name});
+    }
+    return MachineOperand::pseudo(itr->second);
+}
+
+void InstructionSelector::emit_(const MachineInstruction& ins) {
+    // A return ends its block, whatever comes after starts the next one.
+    if (function.blocks.empty() || (!function.blocks.back().instructions.empty() &&
+                                    function.blocks.back().instructions.back().opcode == Opcode::ret)) {
+        function.blocks.emplace_back();
+    }
+    function.blocks.back().instructions.push_back(ins);
+}
+
+std::string InstructionSelector::generate_temp_name_() {
+    return "isel." + std::to_string(temp_count_++);
+}
+
+} // namespace billiec::codegen
@@ -0,0 +1,111 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/LivenessAnalysis.h>
+
+#include <codegen/AssemblerOperands.h>
+#include <codegen/DataflowSolver.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace billiec::codegen {
+
+void LivenessAnalysis::process() {
+    number_operands_();
+
+    // The function's blocks are the basic blocks already, a block falls through unless it returns.
+    cfg = ControlFlowGraph{};
+    int position = 0;
+    for(const auto& curr_block: function.blocks) {
+        int size = static_cast<int>(curr_block.instructions.size());
+        cfg.blocks.push_back(BasicBlock{.begin = position, .end = position + size});
+        position += size;
+    }
+    for(std::size_t block_idx = 0; block_idx + 1 < function.blocks.size(); ++block_idx) {
+        const auto& block_instructions = function.blocks[block_idx].instructions;
+        if (block_instructions.empty() || block_instructions.back().opcode != Opcode::ret) {
+            cfg.add_edge(static_cast<int>(block_idx), static_cast<int>(block_idx) + 1);
+        }
+    }
+
+    DataflowSolver<DataflowDirection::backward, DataflowMeet::union_of> solver{cfg, function.pseudo_registers.size()};
+    for(std::size_t block_idx = 0; block_idx < cfg.blocks.size(); ++block_idx) {
+        // gen is what's read before the block writes it, kill is everything it writes.
+        const auto& block = cfg.blocks[block_idx];
+        auto& gen = solver.gen[block_idx];
+        auto& kill = solver.kill[block_idx];
+        for(int position = block.begin; position < block.end; ++position) {
+            for(int curr_use: uses(position)) {
+                if (!kill.test(curr_use)) {
+                    gen.set(curr_use);
+                }
+            }
+            for(int curr_def: defs(position)) {
+                kill.set(curr_def);
+            }
+        }
+    }
+
+    solver.solve();
+    live_in = std::move(solver.in);
+    live_out = std::move(solver.out);
+}
+
+std::vector<LiveRange> LivenessAnalysis::live_ranges() const {
+    std::vector<LiveRange> ranges(function.pseudo_registers.size(), LiveRange{std::numeric_limits<int>::max(), -1});
+    auto extend = [&ranges](std::size_t idx, int position) {
+        ranges[idx].start = std::min(ranges[idx].start, position);
+        ranges[idx].end = std::max(ranges[idx].end, position);
+    };
+
+    // Anything live out of a block reaches past its last instruction, so nothing else can be
+    // given the same home there.
+    for(std::size_t block_idx = 0; block_idx < cfg.blocks.size(); ++block_idx) {
+        const auto& block = cfg.blocks[block_idx];
+        live_in[block_idx].for_each_set([&](std::size_t idx) {
+            extend(idx, block.begin);
+        });
+        live_out[block_idx].for_each_set([&](std::size_t idx) {
+            extend(idx, block.end);
+        });
+
+        for(int position = block.begin; position < block.end; ++position) {
+            for(int curr_use: uses(position)) {
+                extend(curr_use, position);
+            }
+            for(int curr_def: defs(position)) {
+                extend(curr_def, position);
+            }
+        }
+    }
+
+    return ranges;
+}
+
+void LivenessAnalysis::number_operands_() {
+    instructions.clear();
+    use_begin_.assign(1, 0);
+    def_begin_.assign(1, 0);
+    uses_.clear();
+    defs_.clear();
+
+    for(auto& curr_block: function.blocks) {
+        for(auto& curr_ins: curr_block.instructions) {
+            instructions.push_back(&curr_ins);
+            for_each_operand(curr_ins, [this](MachineOperand& operand, bool is_use, bool is_def) {
+                if (!operand.is(OperandKind::pseudo)) {
+                    return;
+                }
+                if (is_use) {
+                    uses_.push_back(operand.value);
+                }
+                if (is_def) {
+                    defs_.push_back(operand.value);
+                }
+            });
+            use_begin_.push_back(static_cast<int>(uses_.size()));
+            def_begin_.push_back(static_cast<int>(defs_.size()));
+        }
+    }
+}
+
+} // namespace billiec::codegen
@@ -0,0 +1,164 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <codegen/TackyPassValueNumbering.h>
+
+#include <core/Trace.h>
+
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace billiec::codegen {
+
+namespace {
+
+bool is_commutative(scanner::TokenType operation) {
+    return operation == scanner::TokenType::PLUS || operation == scanner::TokenType::STAR;
+}
+
+// Wraps the way the hardware would.  Division is left alone where the hardware and C disagree
+// on what it means, by zero and INT_MIN by -1.
+std::optional<int> fold_unary(scanner::TokenType operation, int operand) {
+    auto bits = static_cast<std::uint32_t>(operand);
+    switch(operation) {
+        case scanner::TokenType::MINUS:
+            return static_cast<int>(0u - bits);
+        case scanner::TokenType::COMPLEMENT:
+            return static_cast<int>(~bits);
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<int> fold_binary(scanner::TokenType operation, int lhs, int rhs) {
+    auto lhs_bits = static_cast<std::uint32_t>(lhs);
+    auto rhs_bits = static_cast<std::uint32_t>(rhs);
+    bool divides = rhs != 0 && !(lhs == std::numeric_limits<int>::min() && rhs == -1);
+    switch(operation) {
+        case scanner::TokenType::PLUS:
+            return static_cast<int>(lhs_bits + rhs_bits);
+        case scanner::TokenType::MINUS:
+            return static_cast<int>(lhs_bits - rhs_bits);
+        case scanner::TokenType::STAR:
+            return static_cast<int>(lhs_bits * rhs_bits);
+        case scanner::TokenType::SLASH:
+            return divides ? std::optional<int>{lhs / rhs} : std::nullopt;
+        case scanner::TokenType::PERCENT:
+            return divides ? std::optional<int>{lhs % rhs} : std::nullopt;
+        default:
+            return std::nullopt;
+    }
+}
+
+} // namespace
+
+std::size_t TackyPassValueNumbering::ExpressionKeyHash::operator()(const ExpressionKey& key) const {
+    auto bits = (static_cast<std::uint64_t>(key.operation) << 1 | static_cast<std::uint64_t>(key.unary)) *
+                0x9e3779b97f4a7c15ull;
+    bits ^= static_cast<std::uint32_t>(key.lhs) * 0xc2b2ae3d27d4eb4full;
+    bits ^= (static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.rhs)) << 32) * 0x165667b19e3779f9ull;
+    return static_cast<std::size_t>(bits ^ (bits >> 29));
+}
+
+void TackyPassValueNumbering::process() {
+    auto& program_node = dynamic_cast<ProgramTackyNode&>(*program);
+    auto& function = dynamic_cast<FunctionTackyNode&>(*program_node.function_definition);
+    TraceSpan span{"function", function.name.lexeme};
+    number_function_(function);
+}
+
+void TackyPassValueNumbering::number_function_(FunctionTackyNode& function) {
+    values_.clear();
+    constant_numbers_.clear();
+    variable_numbers_.clear();
+    expression_numbers_.clear();
+
+    // Operands are rewritten to whatever first held their value as we go, so a dropped
+    // instruction's result is never read again.
+    std::vector<TackyNode::PtrType> kept;
+    kept.reserve(function.instructions.size());
+    for(auto& curr_ins: function.instructions) {
+        if (auto node = dynamic_cast<UnaryTackyNode*>(curr_ins.get())) {
+            int src = number_of_(*node->src);
+            node->src = operand_for_(src);
+            if (values_[src].is_constant) {
+                if (auto value = fold_unary(node->operation.token_type, values_[src].constant)) {
+                    variable_numbers_[dynamic_cast<const VarTackyNode&>(*node->dst).var_name] = constant_number_(*value);
+                    ++folded;
+                    continue;
+                }
+            }
+            if (!define_(*node->dst, ExpressionKey{node->operation.token_type, true, src, -1})) {
+                continue;
+            }
+        } else if (auto node = dynamic_cast<BinaryTackyNode*>(curr_ins.get())) {
+            int src1 = number_of_(*node->src1);
+            int src2 = number_of_(*node->src2);
+            node->src1 = operand_for_(src1);
+            node->src2 = operand_for_(src2);
+            if (values_[src1].is_constant && values_[src2].is_constant) {
+                if (auto value = fold_binary(node->operation.token_type, values_[src1].constant, values_[src2].constant)) {
+                    variable_numbers_[dynamic_cast<const VarTackyNode&>(*node->dst).var_name] = constant_number_(*value);
+                    ++folded;
+                    continue;
+                }
+            }
+            auto key = ExpressionKey{node->operation.token_type, false, src1, src2};
+            if (is_commutative(key.operation) && key.rhs < key.lhs) {
+                std::swap(key.lhs, key.rhs);
+            }
+            if (!define_(*node->dst, key)) {
+                continue;
+            }
+        } else if (auto node = dynamic_cast<ReturnTackyNode*>(curr_ins.get())) {
+            node->return_expr = operand_for_(number_of_(*node->return_expr));
+        }
+        kept.push_back(std::move(curr_ins));
+    }
+    function.instructions = std::move(kept);
+}
+
+// Variables never written here are read as they are, each one its own value.
+int TackyPassValueNumbering::number_of_(const TackyNode& operand) {
+    if (auto constant = dynamic_cast<const IntConstTackyNode*>(&operand)) {
+        return constant_number_(constant->value);
+    }
+
+    const auto& name = dynamic_cast<const VarTackyNode&>(operand).var_name;
+    auto [itr, inserted] = variable_numbers_.try_emplace(name, static_cast<int>(values_.size()));
+    if (inserted) {
+        values_.push_back(Value{.name = name});
+    }
+    return itr->second;
+}
+
+int TackyPassValueNumbering::constant_number_(int value) {
+    auto [itr, inserted] = constant_numbers_.try_emplace(value, static_cast<int>(values_.size()));
+    if (inserted) {
+        values_.push_back(Value{.is_constant = true, .constant = value});
+    }
+    return itr->second;
+}
+
+TackyNode::PtrType TackyPassValueNumbering::operand_for_(int value_number) const {
+    const auto& value = values_[value_number];
+    if (value.is_constant) {
+        return IntConstTackyNode::create(value.constant);
+    }
+    return VarTackyNode::create(value.name);
+}
+
+// Whether the instruction computing key into dst has to stay, false when its value is already around.
+bool TackyPassValueNumbering::define_(const TackyNode& dst, const ExpressionKey& key) {
+    const auto& name = dynamic_cast<const VarTackyNode&>(dst).var_name;
+    auto [itr, inserted] = expression_numbers_.try_emplace(key, static_cast<int>(values_.size()));
+    if (!inserted) {
+        variable_numbers_[name] = itr->second;
+        ++redundant;
+        return false;
+    }
+    values_.push_back(Value{.name = name});
+    variable_numbers_[name] = itr->second;
+    return true;
+}
+
+} // namespace billiec::codegen
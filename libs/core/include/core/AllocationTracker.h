@@ -0,0 +1,91 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace billiec {
+
+/** @brief  Whether the global operator new and delete replacements are compiled in.
+ *
+ * Configure with -DBILLIE_TRACK_ALLOCATIONS=ON to get them, otherwise every count stays zero.
+ */
+#ifdef BILLIE_TRACK_ALLOCATIONS
+inline constexpr bool allocation_tracking_enabled = true;
+#else
+inline constexpr bool allocation_tracking_enabled = false;
+#endif
+
+/** @brief  Running totals of what the global operator new and delete handled. */
+struct AllocationCounts {
+    std::uint64_t allocations{0};
+    std::uint64_t bytes{0};
+    std::uint64_t frees{0};
+
+    AllocationCounts& operator+=(const AllocationCounts& other) {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        frees += other.frees;
+        return *this;
+    }
+};
+
+/** @brief  What this thread has allocated so far, per thread so batch and server compiles don't mix. */
+AllocationCounts thread_allocation_counts();
+
+/** @brief  Tags the allocations this thread makes while the scope is open.
+ *
+ * Scopes nest, an allocation is attributed to the innermost open scope.  \c counts covers the
+ * scope and everything nested in it, the process-wide per-tag totals only get what was made
+ * directly under each tag.  The tag is kept by pointer, pass a string literal.
+ */
+class AllocationScope {
+public:
+    explicit AllocationScope(const char* tag);
+    ~AllocationScope();
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    const char* tag() const {
+        return tag_;
+    }
+
+    /** @brief  Allocations made since the scope opened, nested scopes included. */
+    AllocationCounts counts() const;
+
+    /** @brief  The innermost open scope's tag on this thread, null when there's none. */
+    static const char* current_tag();
+
+private:
+    const char* tag_;
+    AllocationScope* parent_;
+    AllocationCounts start_;
+    AllocationCounts own_;          ///< Made while this was the innermost scope.
+
+    friend void record_allocation(std::uint64_t bytes);
+    friend void record_free();
+};
+
+struct TaggedAllocationCounts {
+    std::string tag;
+    AllocationCounts counts;
+};
+
+/** @brief  Allocations made directly under each tag by every closed scope in the process so far. */
+std::vector<TaggedAllocationCounts> allocation_counts_by_tag();
+
+/** @brief  Whether \c counts stays within \c max_per_unit allocations for each of \c units, plus \c allowance.
+ *
+ * For budgets like "at most one allocation per token" or, with no units, "none at all".
+ */
+inline bool within_allocation_budget(const AllocationCounts& counts,
+                                     double max_per_unit,
+                                     std::uint64_t units,
+                                     std::uint64_t allowance = 0) {
+    return static_cast<double>(counts.allocations) <= max_per_unit * static_cast<double>(units) +
+                                                      static_cast<double>(allowance);
+}
+
+} // namespace billiec
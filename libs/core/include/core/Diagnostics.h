@@ -0,0 +1,71 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace billiec {
+
+/** @brief  One problem found in a source, recorded as is and only turned into text when printed.
+ *
+ * \c message is a string literal and the text it's about is a span of the source, so reporting
+ * one copies a few words and never allocates a string.  Only the preprocessor, whose problems can
+ * be in a header or name a macro, fills in \c file and \c detail.
+ */
+struct Diagnostic {
+    std::error_code code;
+    const char*     message{""};
+    std::uint32_t   offset{0};          ///< Where in the source it is, in bytes.
+    std::uint32_t   length{0};          ///< How much of the source it's about, quoted when printed.
+    std::int32_t    line{0};
+    std::string     file{};             ///< Set when the line is in another file, a header, the offset then means nothing.
+    std::string     detail{};           ///< Text only known at run time, a macro or header name.
+};
+
+/** @brief  Collects every diagnostic of a compile so all of them can be reported in one pass. */
+class Diagnostics {
+public:
+    void report(const Diagnostic& diagnostic) {
+        diagnostics_.push_back(diagnostic);
+    }
+
+    /** @brief  Takes over every record of \c other, after the ones already here. */
+    void append(const Diagnostics& other) {
+        diagnostics_.insert(diagnostics_.end(), other.diagnostics_.begin(), other.diagnostics_.end());
+    }
+
+    bool empty() const {
+        return diagnostics_.empty();
+    }
+
+    std::size_t size() const {
+        return diagnostics_.size();
+    }
+
+    const Diagnostic& front() const {
+        return diagnostics_.front();
+    }
+
+    auto begin() const {
+        return diagnostics_.begin();
+    }
+
+    auto end() const {
+        return diagnostics_.end();
+    }
+
+    /** @brief  Prints each as file:line:column: error: message, \c source is what the offsets point into. */
+    void print(std::ostream& out, std::string_view source, std::string_view file_name) const;
+
+private:
+    std::vector<Diagnostic> diagnostics_;
+
+    static void print_detail_(std::ostream& out, const Diagnostic& diagnostic);
+};
+
+} // namespace billiec
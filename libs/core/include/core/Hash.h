@@ -0,0 +1,53 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace billiec {
+
+namespace hash_detail {
+
+constexpr std::uint64_t p0 = 0xa0761d6478bd642full;
+constexpr std::uint64_t p1 = 0xe7037ed1a0b428dbull;
+constexpr std::uint64_t p2 = 0x8ebc6af09c88c6e3ull;
+
+// Folds the full 128-bit product back to 64 bits, every input bit reaches every output bit.
+inline std::uint64_t mix(std::uint64_t lhs, std::uint64_t rhs) {
+    auto product = static_cast<unsigned __int128>(lhs) * rhs;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+inline std::uint64_t load64(const char* bytes) {
+    std::uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+} // namespace hash_detail
+
+/** @brief  Fast non-cryptographic 64-bit hash of a byte string, 16 bytes a step.
+ *
+ * Good enough to key caches on, chain calls through \c seed to hash several strings as one.
+ */
+inline std::uint64_t hash_bytes(std::string_view bytes, std::uint64_t seed = 0) {
+    using namespace hash_detail;
+    const char* curr = bytes.data();
+    std::size_t remaining = bytes.size();
+    std::uint64_t state = seed ^ mix(seed ^ p0, p1);
+
+    while(remaining >= 16) {
+        state = mix(load64(curr) ^ p1, load64(curr + 8) ^ state);
+        curr += 16;
+        remaining -= 16;
+    }
+
+    // The tail is padded out with zeros, the length below keeps "a" and "a\0" apart.
+    char tail[16] = {};
+    std::memcpy(tail, curr, remaining);
+    state = mix(load64(tail) ^ p1, load64(tail + 8) ^ state);
+    return mix(state ^ p2, static_cast<std::uint64_t>(bytes.size()) ^ p0);
+}
+
+} // namespace billiec
@@ -0,0 +1,27 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <string_view>
+
+namespace billiec {
+
+/** @brief  Writes \c text as a quoted JSON string, escaping what JSON requires. */
+inline void write_json_string(std::ostream& out, std::string_view text) {
+    out << '"';
+    for(char curr_char: text) {
+        if (curr_char == '"' || curr_char == '\\') {
+            out << '\\' << curr_char;
+        } else if (static_cast<unsigned char>(curr_char) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", curr_char);
+            out << escaped;
+        } else {
+            out << curr_char;
+        }
+    }
+    out << '"';
+}
+
+} // namespace billiec
@@ -0,0 +1,36 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace billiec {
+
+/** @brief  A whole file mapped read-only into memory, unmapped again when this goes. */
+class MappedFile {
+public:
+    /** @brief  Maps the file at \c path, nothing when it can't be opened or is empty. */
+    static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** @brief  The file's bytes, page aligned. */
+    std::string_view bytes() const {
+        return {static_cast<const char*>(data_), size_};
+    }
+
+private:
+    void* data_{nullptr};
+    std::size_t size_{0};
+
+    MappedFile(void* data, std::size_t size);
+};
+
+} // namespace billiec
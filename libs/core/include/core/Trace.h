@@ -0,0 +1,78 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace billiec {
+
+/** @brief  One finished span, a Chrome trace "complete" event. */
+struct TraceEvent {
+    std::string name;
+    const char* category;
+    std::int64_t start_ns{0};
+    std::int64_t duration_ns{0};
+    std::uint32_t thread_id{0};
+};
+
+/** @brief  Process-wide collector of trace spans, off until \c start is called.
+ *
+ * Written out in the Chrome trace-event format that chrome://tracing and Perfetto load, each span
+ * on the thread that ran it.
+ */
+class Tracer {
+public:
+    static void start();
+
+    static bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    static void record(TraceEvent event);
+
+    /** @brief  Nanoseconds since tracing started. */
+    static std::int64_t now_ns();
+
+    /** @brief  The calling thread's id as the kernel knows it. */
+    static std::uint32_t thread_id();
+
+    static void write_json(std::ostream& out);
+
+private:
+    static inline std::atomic<bool> enabled_{false};
+};
+
+/** @brief  Records the time from construction to destruction as a span, when tracing is on.
+ *
+ * Spans nest by time on a thread, so one opened inside another shows up under it in a flame view.
+ * The category is kept by pointer, pass a string literal.
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char* category, std::string_view name) {
+        if (Tracer::enabled()) {
+            category_ = category;
+            name_ = name;
+            start_ns_ = Tracer::now_ns();
+        }
+    }
+
+    ~TraceSpan() {
+        if (category_ != nullptr) {
+            Tracer::record({std::move(name_), category_, start_ns_, Tracer::now_ns() - start_ns_, Tracer::thread_id()});
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* category_{nullptr};
+    std::string name_;
+    std::int64_t start_ns_{0};
+};
+
+} // namespace billiec
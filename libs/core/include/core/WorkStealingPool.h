@@ -0,0 +1,62 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace billiec {
+
+/** @brief  Fixed set of worker threads, each with its own task deque.
+ *
+ * Workers take from the front of their own deque and, once it runs dry, steal from the back of
+ * the others', so one long task doesn't leave the tasks queued behind it waiting.  Tasks must not
+ * throw, catch inside the task and record the failure there.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /** @brief  Starts \c thread_count workers, zero means one per hardware thread. */
+    explicit WorkStealingPool(std::size_t thread_count = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /** @brief  Queues a task, the deques are filled round robin. */
+    void submit(Task task);
+
+    /** @brief  Blocks until every task submitted so far has run. */
+    void wait();
+
+    std::size_t thread_count() const {
+        return workers_.size();
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    std::size_t queued_{0};     ///< Submitted and not yet taken by a worker.
+    std::size_t unfinished_{0}; ///< Submitted and not yet finished.
+    std::size_t next_queue_{0};
+    bool stopping_{false};
+
+    void run_(std::size_t index);
+    bool take_(std::size_t index, Task& task);
+};
+
+} // namespace billiec
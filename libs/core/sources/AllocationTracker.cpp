@@ -0,0 +1,176 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <core/AllocationTracker.h>
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace billiec {
+
+namespace {
+
+// Plain thread_locals with no constructor, so counting never allocates or runs initialization.
+thread_local AllocationCounts thread_counts;
+thread_local AllocationScope* innermost_scope = nullptr;
+
+std::mutex& tag_totals_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Keyed by name rather than pointer, the same literal can sit at different addresses per library.
+std::map<std::string, AllocationCounts>& tag_totals() {
+    static std::map<std::string, AllocationCounts> totals;
+    return totals;
+}
+
+} // namespace
+
+void record_allocation(std::uint64_t bytes) {
+    ++thread_counts.allocations;
+    thread_counts.bytes += bytes;
+    if (innermost_scope != nullptr) {
+        ++innermost_scope->own_.allocations;
+        innermost_scope->own_.bytes += bytes;
+    }
+}
+
+void record_free() {
+    ++thread_counts.frees;
+    if (innermost_scope != nullptr) {
+        ++innermost_scope->own_.frees;
+    }
+}
+
+AllocationCounts thread_allocation_counts() {
+    return thread_counts;
+}
+
+AllocationScope::AllocationScope(const char* tag):
+    tag_{tag},
+    parent_{innermost_scope},
+    start_{thread_counts} {
+    innermost_scope = this;
+}
+
+AllocationScope::~AllocationScope() {
+    innermost_scope = parent_;
+    if constexpr (allocation_tracking_enabled) {
+        // The map's own allocations land in the parent scope, or nowhere at the top level.
+        std::lock_guard lock{tag_totals_mutex()};
+        tag_totals()[tag_] += own_;
+    }
+}
+
+AllocationCounts AllocationScope::counts() const {
+    auto now = thread_counts;
+    return {now.allocations - start_.allocations, now.bytes - start_.bytes, now.frees - start_.frees};
+}
+
+const char* AllocationScope::current_tag() {
+    return innermost_scope != nullptr ? innermost_scope->tag_ : nullptr;
+}
+
+std::vector<TaggedAllocationCounts> allocation_counts_by_tag() {
+    std::lock_guard lock{tag_totals_mutex()};
+    std::vector<TaggedAllocationCounts> result;
+    for(const auto& [tag, counts]: tag_totals()) {
+        result.push_back({tag, counts});
+    }
+    return result;
+}
+
+} // namespace billiec
+
+#ifdef BILLIE_TRACK_ALLOCATIONS
+
+namespace {
+
+void* counted_allocate(std::size_t size) {
+    billiec::record_allocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_allocate(std::size_t size, std::align_val_t alignment) {
+    billiec::record_allocation(size);
+    auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void counted_free(void* memory) {
+    if (memory != nullptr) {
+        billiec::record_free();
+    }
+    std::free(memory);
+}
+
+void* allocate_or_throw(void* memory) {
+    if (memory == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return memory;
+}
+
+} // namespace
+
+// Replacements for the global allocation functions, every one the standard library could pick.
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(counted_allocate(size));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(counted_allocate(size));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(counted_allocate(size, alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(counted_allocate(size, alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    counted_free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+#endif
@@ -0,0 +1,37 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <core/Diagnostics.h>
+
+#include <algorithm>
+
+namespace billiec {
+
+void Diagnostics::print(std::ostream& out, std::string_view source, std::string_view file_name) const {
+    for(const auto& curr_diagnostic: diagnostics_) {
+        if (!curr_diagnostic.file.empty()) {
+            out << curr_diagnostic.file << ":" << curr_diagnostic.line << ": error: " << curr_diagnostic.message;
+            print_detail_(out, curr_diagnostic);
+            continue;
+        }
+
+        // Tokens that came from somewhere else, a header or a macro, can point past this source.
+        auto offset = std::min<std::size_t>(curr_diagnostic.offset, source.size());
+        auto line_start = source.rfind('\n', offset == 0 ? 0 : offset - 1);
+        auto column = offset - (line_start == std::string_view::npos || offset == 0 ? 0 : line_start + 1) + 1;
+
+        out << file_name << ":" << curr_diagnostic.line << ":" << column << ": error: " << curr_diagnostic.message;
+        auto text = source.substr(offset, curr_diagnostic.length);
+        if (!text.empty()) {
+            out << " '" << text << "'";
+        }
+        print_detail_(out, curr_diagnostic);
+    }
+}
+
+void Diagnostics::print_detail_(std::ostream& out, const Diagnostic& diagnostic) {
+    if (!diagnostic.detail.empty()) {
+        out << ": " << diagnostic.detail;
+    }
+    out << " [" << diagnostic.code.message() << "]\n";
+}
+
+} // namespace billiec
@@ -0,0 +1,59 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <core/MappedFile.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace billiec {
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    // The mapping outlives the descriptor, there's no need to keep it open.
+    struct stat status{};
+    void* data = MAP_FAILED;
+    if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+        data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return std::nullopt;
+    }
+    return MappedFile{data, static_cast<std::size_t>(status.st_size)};
+}
+
+MappedFile::MappedFile(void* data, std::size_t size):
+    data_{data},
+    size_{size} {
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept:
+    data_{std::exchange(other.data_, nullptr)},
+    size_{std::exchange(other.size_, 0)} {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+    }
+}
+
+} // namespace billiec
@@ -0,0 +1,79 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <core/Trace.h>
+#include <core/Json.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace billiec {
+
+namespace {
+
+std::mutex& events_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<TraceEvent>& events() {
+    static std::vector<TraceEvent> recorded;
+    return recorded;
+}
+
+std::chrono::steady_clock::time_point& epoch() {
+    static std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    return started;
+}
+
+} // namespace
+
+void Tracer::start() {
+    epoch() = std::chrono::steady_clock::now();
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::record(TraceEvent event) {
+    std::lock_guard lock{events_mutex()};
+    events().push_back(std::move(event));
+}
+
+std::int64_t Tracer::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+std::uint32_t Tracer::thread_id() {
+    thread_local std::uint32_t id = static_cast<std::uint32_t>(::gettid());
+    return id;
+}
+
+void Tracer::write_json(std::ostream& out) {
+    std::lock_guard lock{events_mutex()};
+    auto pid = ::getpid();
+    auto flags = out.flags();
+    auto precision = out.precision();
+
+    // Timestamps are in microseconds, three decimals keeps the nanoseconds.
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for(std::size_t idx = 0; idx < events().size(); ++idx) {
+        const auto& curr_event = events()[idx];
+        out << "{\"name\":";
+        write_json_string(out, curr_event.name);
+        out << ",\"cat\":";
+        write_json_string(out, curr_event.category);
+        out << ",\"ph\":\"X\",\"ts\":" << static_cast<double>(curr_event.start_ns) / 1e3
+            << ",\"dur\":" << static_cast<double>(curr_event.duration_ns) / 1e3
+            << ",\"pid\":" << pid
+            << ",\"tid\":" << curr_event.thread_id << "}";
+        out << (idx + 1 == events().size() ? "\n" : ",\n");
+    }
+    out << "]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace billiec
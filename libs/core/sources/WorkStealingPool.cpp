@@ -0,0 +1,111 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <core/WorkStealingPool.h>
+
+#include <algorithm>
+
+namespace billiec {
+
+WorkStealingPool::WorkStealingPool(std::size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(std::size_t idx = 0; idx < thread_count; ++idx) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+    for(std::size_t idx = 0; idx < thread_count; ++idx) {
+        workers_.emplace_back([this, idx] { run_(idx); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for(auto& curr_worker: workers_) {
+        curr_worker.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    std::size_t index;
+    {
+        std::lock_guard lock{mutex_};
+        index = next_queue_++ % queues_.size();
+        ++queued_;
+        ++unfinished_;
+    }
+
+    {
+        std::lock_guard lock{queues_[index]->mutex};
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    work_available_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock lock{mutex_};
+    all_done_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+void WorkStealingPool::run_(std::size_t index) {
+    Task task;
+    while(true) {
+        {
+            std::unique_lock lock{mutex_};
+            work_available_.wait(lock, [this] { return stopping_ || queued_ != 0; });
+            if (queued_ == 0) {
+                return;
+            }
+        }
+
+        // Another worker can get to the task first, then this one just goes back to waiting.
+        if (!take_(index, task)) {
+            continue;
+        }
+
+        task();
+        task = nullptr;
+
+        std::lock_guard lock{mutex_};
+        if (--unfinished_ == 0) {
+            all_done_.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::take_(std::size_t index, Task& task) {
+    auto finish_take = [this] {
+        std::lock_guard lock{mutex_};
+        --queued_;
+    };
+
+    {
+        auto& own = *queues_[index];
+        std::lock_guard lock{own.mutex};
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            finish_take();
+            return true;
+        }
+    }
+
+    for(std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            finish_take();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace billiec
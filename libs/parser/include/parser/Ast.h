@@ -15,6 +15,7 @@ struct ProgramNode;
 struct FunctionNode;
 struct ReturnNode;
 struct UnaryNode;
+struct BinaryNode;
 struct LiteralNode;
 
 
@@ -29,6 +30,7 @@ struct AstNodeVisitor {
     virtual R visit(const FunctionNode& node) = 0;
     virtual R visit(const ReturnNode& node) = 0;
     virtual R visit(const UnaryNode& node) = 0;
+    virtual R visit(const BinaryNode& node) = 0;
     virtual R visit(const LiteralNode& node) = 0;
 };
 
@@ -55,6 +57,10 @@ struct LiteralNode: public AstNode  {
     }
 };
 
+// Nested expressions can go far deeper than the native stack, so their subtrees are torn down
+// from a worklist instead of each destructor recursing into the next.
+inline void release_subtrees(AstNode::PtrType first, AstNode::PtrType second = nullptr);
+
 // ---
 
 struct UnaryNode: public AstNode {
@@ -69,6 +75,12 @@ struct UnaryNode: public AstNode {
         expr{std::move(expr)} {
     }
     
+    ~UnaryNode() override {
+        if (expr) {
+            release_subtrees(std::move(expr));
+        }
+    }
+    
     static PtrType create(const scanner::Token& operation,
                           AstNode::PtrType expr) {
         return std::make_unique<UnaryNode>(operation, std::move(expr));
@@ -77,6 +89,53 @@ struct UnaryNode: public AstNode {
 
 // ---
 
+struct BinaryNode: public AstNode {
+    using PtrType = std::unique_ptr<BinaryNode>;
+    
+    scanner::Token operation;
+    AstNode::PtrType left;
+    AstNode::PtrType right;
+
+    BinaryNode(const scanner::Token& operation,
+               AstNode::PtrType left,
+               AstNode::PtrType right):
+        operation{operation},
+        left{std::move(left)},
+        right{std::move(right)} {
+    }
+    
+    static PtrType create(const scanner::Token& operation,
+                          AstNode::PtrType left,
+                          AstNode::PtrType right) {
+        return std::make_unique<BinaryNode>(operation, std::move(left), std::move(right));
+    }
+    
+    ~BinaryNode() override {
+        if (left || right) {
+            release_subtrees(std::move(left), std::move(right));
+        }
+    }
+};
+
+inline void release_subtrees(AstNode::PtrType first, AstNode::PtrType second) {
+    std::vector<AstNode::PtrType> pending;
+    pending.push_back(std::move(first));
+    pending.push_back(std::move(second));
+    while(!pending.empty()) {
+        // Children are moved out first, so the node goes without recursing.
+        auto curr_node = std::move(pending.back());
+        pending.pop_back();
+        if (auto unary = dynamic_cast<UnaryNode*>(curr_node.get())) {
+            pending.push_back(std::move(unary->expr));
+        } else if (auto binary = dynamic_cast<BinaryNode*>(curr_node.get())) {
+            pending.push_back(std::move(binary->left));
+            pending.push_back(std::move(binary->right));
+        }
+    }
+}
+
+// ---
+
 struct ReturnNode: public AstNode {
     using PtrType = std::unique_ptr<ReturnNode>;
     
@@ -148,6 +207,8 @@ typename T::ReturnType accept(T& visitor, const AstNode::PtrType& node) {
         return visitor.visit(*actual_node);
     } else if (auto actual_node = dynamic_cast<const UnaryNode*>(node.get())) {
         return visitor.visit(*actual_node);
+    } else if (auto actual_node = dynamic_cast<const BinaryNode*>(node.get())) {
+        return visitor.visit(*actual_node);
     } else if (auto actual_node = dynamic_cast<const LiteralNode*>(node.get())) {
         return visitor.visit(*actual_node);
     } else {
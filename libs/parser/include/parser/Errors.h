@@ -1,4 +1,6 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
 #include <system_error>
 
 namespace billiec::parser {
@@ -1,8 +1,10 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #pragma once
 
+#include <core/Diagnostics.h>
 #include <core/ErrorHelpers.h>
 #include <parser/Ast.h>
+#include <parser/Errors.h>
 #include <scanner/Token.h>
 
 #include <expected>
@@ -15,22 +17,32 @@ class LanguageParser {
 private:
     std::vector<scanner::Token> tokens_;
     int curr_token_idx_{0};
+    Diagnostics diagnostics_;
+    
+    template<typename T>
+    using Parsed = std::expected<T, Diagnostic>;
     
 public:
     LanguageParser(std::vector<scanner::Token> tokens);
     
+    /** @brief  Parses the program, skipping past a bad statement to the next so every error is reported. */
+    std::expected<ProgramNode::PtrType, Diagnostics> parse();
+    
+    /** @brief  Like \c parse, but throws a ParserError for the first error. */
     ProgramNode::PtrType parse_program();
     
 private:
-    FunctionNode::PtrType parse_function_stmt_();
-    std::vector<AstNode::PtrType> parse_block_();
-    AstNode::PtrType parse_stmt_();
-    AstNode::PtrType parse_return_stmt_();
-    AstNode::PtrType parse_expr_();
+    Parsed<FunctionNode::PtrType> parse_function_stmt_();
+    Parsed<std::vector<AstNode::PtrType>> parse_block_();
+    Parsed<AstNode::PtrType> parse_stmt_();
+    Parsed<AstNode::PtrType> parse_return_stmt_();
+    Parsed<AstNode::PtrType> parse_expr_();
     AstNode::PtrType parse_literal_expr_();
+    void synchronize_();
+    Diagnostic error_(errc code, const char* message);
     bool check_(scanner::TokenType type);
     bool match_(const std::vector<scanner::TokenType>& token_types);
-    const scanner::Token& consume_(scanner::TokenType token_type, const std::string& message);
+    Parsed<scanner::Token> consume_(scanner::TokenType token_type, const char* message);
     const scanner::Token& peek_();
     const scanner::Token& advance_();
     const scanner::Token& previous_();
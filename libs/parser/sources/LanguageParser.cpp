@@ -4,73 +4,221 @@
 #include <parser/Errors.h>
 #include <parser/ParserError.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
 namespace billiec::parser {
 
+namespace {
+
+// Binding strength of the binary operators, -1 for anything that isn't one.
+int binary_precedence(scanner::TokenType type) {
+    switch(type) {
+        case scanner::TokenType::STAR:
+        case scanner::TokenType::SLASH:
+        case scanner::TokenType::PERCENT:
+            return 50;
+        case scanner::TokenType::PLUS:
+        case scanner::TokenType::MINUS:
+            return 45;
+        default:
+            return -1;
+    }
+}
+
+} // namespace
+
 LanguageParser::LanguageParser(std::vector<scanner::Token> tokens):
     tokens_{std::move(tokens)} {
+    // Every lookahead stops at an end marker, so one is added when the scanner didn't.
+    if (tokens_.empty() || tokens_.back().token_type != scanner::TokenType::ENDOFFILE) {
+        scanner::Token end_token{
+            .token_type = scanner::TokenType::ENDOFFILE,
+            .token_value = {},
+            .lexeme = {},
+            .line = 0,
+            .offset = 0
+        };
+        if (!tokens_.empty()) {
+            end_token.line = tokens_.back().line;
+            end_token.offset = tokens_.back().offset + static_cast<std::uint32_t>(tokens_.back().lexeme.size());
+        }
+        tokens_.push_back(std::move(end_token));
+    }
+}
+
+std::expected<ProgramNode::PtrType, Diagnostics> LanguageParser::parse() {
+    auto function = parse_function_stmt_();
+    if (!function) {
+        diagnostics_.report(function.error());
+    }
+    
+    if (!diagnostics_.empty()) {
+        return std::unexpected{std::move(diagnostics_)};
+    }
+    return ProgramNode::create(std::move(*function));
 }
 
 ProgramNode::PtrType LanguageParser::parse_program() {
-    return ProgramNode::create(parse_function_stmt_());
+    auto program = parse();
+    if (!program) {
+        const auto& first = program.error().front();
+        ErrorCode ec{first.code, first.message};
+        ec << "line: " << first.line;
+        throw ParserError{std::move(ec)};
+    }
+    return std::move(*program);
 }
 
-FunctionNode::PtrType LanguageParser::parse_function_stmt_() {
-    consume_(scanner::TokenType::INT, "Expected int");
+LanguageParser::Parsed<FunctionNode::PtrType> LanguageParser::parse_function_stmt_() {
+    if (auto token = consume_(scanner::TokenType::INT, "Expected int"); !token) {
+        return std::unexpected{token.error()};
+    }
     auto func_name_token = consume_(scanner::TokenType::IDENTIFIER, "Expected name of function.");
-    consume_(scanner::TokenType::LEFT_PAREN, "Expected left paren");
-    consume_(scanner::TokenType::VOID, "Expected void");
-    consume_(scanner::TokenType::RIGHT_PAREN, "Expected right paren");
+    if (!func_name_token) {
+        return std::unexpected{func_name_token.error()};
+    }
     
-    consume_(scanner::TokenType::LEFT_BRACE, "Expected left brace");
+    const std::pair<scanner::TokenType, const char*> signature[] = {
+        {scanner::TokenType::LEFT_PAREN, "Expected left paren"},
+        {scanner::TokenType::VOID, "Expected void"},
+        {scanner::TokenType::RIGHT_PAREN, "Expected right paren"},
+        {scanner::TokenType::LEFT_BRACE, "Expected left brace"}
+    };
+    for(auto [type, message]: signature) {
+        if (auto token = consume_(type, message); !token) {
+            return std::unexpected{token.error()};
+        }
+    }
     
-    return FunctionNode::create(func_name_token, parse_block_());
+    auto body = parse_block_();
+    if (!body) {
+        return std::unexpected{body.error()};
+    }
+    return FunctionNode::create(*func_name_token, std::move(*body));
 }
 
-std::vector<AstNode::PtrType> LanguageParser::parse_block_() {
+// A statement that fails is recorded and skipped, the block only fails itself when it isn't closed.
+LanguageParser::Parsed<std::vector<AstNode::PtrType>> LanguageParser::parse_block_() {
     std::vector<AstNode::PtrType> statements;
     
     while(!check_(scanner::TokenType::RIGHT_BRACE) && !is_at_end_()) {
-        statements.push_back(parse_stmt_());
+        auto statement = parse_stmt_();
+        if (!statement) {
+            diagnostics_.report(statement.error());
+            synchronize_();
+            continue;
+        }
+        statements.push_back(std::move(*statement));
     }
     
-    consume_(scanner::TokenType::RIGHT_BRACE, "Expected right brace");
+    if (auto token = consume_(scanner::TokenType::RIGHT_BRACE, "Expected right brace"); !token) {
+        return std::unexpected{token.error()};
+    }
     
     return statements;
 }
 
-AstNode::PtrType LanguageParser::parse_stmt_() {
+LanguageParser::Parsed<AstNode::PtrType> LanguageParser::parse_stmt_() {
     if (match_({scanner::TokenType::RETURN})) {
         return parse_return_stmt_();
     }
     
-    // TODO: Error..
+    return std::unexpected{error_(errc::parser_unexpected_token, "Expected a statement")};
 }
 
-AstNode::PtrType LanguageParser::parse_return_stmt_() {
+LanguageParser::Parsed<AstNode::PtrType> LanguageParser::parse_return_stmt_() {
     scanner::Token keyword = previous_();
     
     auto return_expr = parse_expr_();
+    if (!return_expr) {
+        return return_expr;
+    }
     
-    consume_(scanner::TokenType::SEMICOLON, "Expected ';' after return value.");
+    if (auto token = consume_(scanner::TokenType::SEMICOLON, "Expected ';' after return value."); !token) {
+        return std::unexpected{token.error()};
+    }
     
-    return ReturnNode::create(keyword, std::move(return_expr));
+    return ReturnNode::create(keyword, std::move(*return_expr));
 }
 
-AstNode::PtrType LanguageParser::parse_expr_() {
-    if (match_({scanner::TokenType::NUMBER})) {
-        return parse_literal_expr_();
-    } else if (match_({scanner::TokenType::MINUS, scanner::TokenType::COMPLEMENT})) {
-        auto token = previous_();
-        auto expr = parse_expr_();
-        return parser::UnaryNode::create(token, std::move(expr));
-    } else if (match_({scanner::TokenType::LEFT_PAREN})) {
-        auto expr =  parse_expr_();
-        consume_(scanner::TokenType::RIGHT_PAREN, "Expected ')'");
-        return expr;
-    } else {
-        ErrorCode ec{make_error_code(errc::parser_invalid_expression), "Invalid expression."};
-        throw ParserError{std::move(ec)};
+// Operator precedence with explicit stacks, so how deeply an expression nests is bounded by the
+// heap instead of the native stack.  Every binary operator is left associative and the prefix
+// operators bind tighter than any of them.
+LanguageParser::Parsed<AstNode::PtrType> LanguageParser::parse_expr_() {
+    enum class Pending {
+        unary,
+        binary,
+        paren
+    };
+    std::vector<AstNode::PtrType> operands;
+    std::vector<std::pair<Pending, scanner::Token>> operators;
+    
+    auto reduce = [&operands, &operators] {
+        auto [kind, token] = std::move(operators.back());
+        operators.pop_back();
+        auto right = std::move(operands.back());
+        operands.pop_back();
+        if (kind == Pending::unary) {
+            operands.push_back(UnaryNode::create(token, std::move(right)));
+        } else {
+            auto left = std::move(operands.back());
+            operands.pop_back();
+            operands.push_back(BinaryNode::create(token, std::move(left), std::move(right)));
+        }
+    };
+    
+    bool expect_operand = true;
+    while(true) {
+        if (expect_operand) {
+            if (match_({scanner::TokenType::NUMBER})) {
+                operands.push_back(parse_literal_expr_());
+                expect_operand = false;
+            } else if (match_({scanner::TokenType::MINUS, scanner::TokenType::COMPLEMENT})) {
+                operators.emplace_back(Pending::unary, previous_());
+            } else if (match_({scanner::TokenType::LEFT_PAREN})) {
+                operators.emplace_back(Pending::paren, previous_());
+            } else {
+                return std::unexpected{error_(errc::parser_invalid_expression, "Invalid expression.")};
+            }
+            continue;
+        }
+        
+        int precedence = is_at_end_() ? -1 : binary_precedence(peek_().token_type);
+        if (precedence >= 0) {
+            while(!operators.empty() &&
+                  (operators.back().first == Pending::unary ||
+                   (operators.back().first == Pending::binary &&
+                    binary_precedence(operators.back().second.token_type) >= precedence))) {
+                reduce();
+            }
+            operators.emplace_back(Pending::binary, advance_());
+            expect_operand = true;
+            continue;
+        }
+        
+        // A ')' closes the innermost '(', anything else ends the expression.
+        auto open_paren = std::find_if(operators.rbegin(), operators.rend(),
+                                       [](const auto& pending) { return pending.first == Pending::paren; });
+        if (!check_(scanner::TokenType::RIGHT_PAREN) || open_paren == operators.rend()) {
+            break;
+        }
+        while(operators.back().first != Pending::paren) {
+            reduce();
+        }
+        operators.pop_back();
+        advance_();
     }
+    
+    while(!operators.empty()) {
+        if (operators.back().first == Pending::paren) {
+            return std::unexpected{error_(errc::parser_unexpected_token, "Expected ')'")};
+        }
+        reduce();
+    }
+    
+    return std::move(operands.back());
 }
 
 AstNode::PtrType LanguageParser::parse_literal_expr_() {
@@ -98,13 +246,33 @@ bool LanguageParser::match_(const std::vector<scanner::TokenType>& match_types)
     return false;
 }
 
-const scanner::Token& LanguageParser::consume_(scanner::TokenType token_type, const std::string& message) {
+LanguageParser::Parsed<scanner::Token> LanguageParser::consume_(scanner::TokenType token_type, const char* message) {
     if (check_(token_type)) {
         return advance_();
     }
     
-    ErrorCode ec{make_error_code(errc::parser_unexpected_token), message};
-    throw ParserError{std::move(ec)};
+    return std::unexpected{error_(errc::parser_unexpected_token, message)};
+}
+
+// Skips to just past the next ';', or up to the '}' closing the block, whichever is first.
+void LanguageParser::synchronize_() {
+    while(!is_at_end_() && !check_(scanner::TokenType::RIGHT_BRACE)) {
+        if (advance_().token_type == scanner::TokenType::SEMICOLON) {
+            return;
+        }
+    }
+}
+
+// About the token the parser is looking at, the end of the input quotes nothing.
+Diagnostic LanguageParser::error_(errc code, const char* message) {
+    const auto& token = peek_();
+    return Diagnostic{
+        .code = make_error_code(code),
+        .message = message,
+        .offset = token.offset,
+        .length = static_cast<std::uint32_t>(token.lexeme.size()),
+        .line = token.line
+    };
 }
 
 
@@ -6,7 +6,16 @@ namespace billiec::scanner {
 
 enum class errc {
     scanner_err_none = 0x00,
-    scanner_err_invalid_token
+    scanner_err_invalid_token,
+    scanner_err_unterminated_comment,
+    scanner_err_number_out_of_range,
+    preprocessor_err_bad_directive,
+    preprocessor_err_include_not_found,
+    preprocessor_err_include_depth,
+    preprocessor_err_unbalanced_conditional,
+    preprocessor_err_macro_arguments,
+    preprocessor_err_bad_expression,
+    preprocessor_err_error_directive
 };
 
 std::error_code make_error_code(errc err);
@@ -0,0 +1,76 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <scanner/SourceFileCache.h>
+#include <scanner/Token.h>
+
+#include <core/MappedFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace billiec::scanner {
+
+/** @brief  A macro as it goes into a precompiled header. */
+struct PrecompiledMacro {
+    std::string name;
+    bool function_like{false};
+    std::vector<std::string> parameters;
+    std::vector<Token> body;
+};
+
+/** @brief  Everything preprocessing a header left behind, what a precompiled header is written from. */
+struct PrecompiledHeaderContents {
+    std::filesystem::path header;
+    std::vector<std::pair<std::string, std::uint64_t>> dependencies;   ///< Every file read, with its content hash.
+    std::vector<PrecompiledMacro> macros;
+    std::vector<std::string> once_files;
+    std::vector<Token> tokens;          ///< What the header expanded to besides its macros.
+};
+
+/** @brief  A preprocessed header snapshot, mapped straight from its file.
+ *
+ * The file holds fixed-size records and a string pool, plus a hash table over the macro names.
+ * Opening it maps the file and checks the section bounds, nothing is copied; a macro is only turned
+ * back into tokens when it's looked up, so the thousands a header defines and a file never uses
+ * cost nothing.  \c identity is whatever else the snapshot depends on, a compiler build or
+ * different -D flags make it a different one.
+ */
+class PrecompiledHeader {
+public:
+    /** @brief  Writes \c contents to \c path through a temporary, so readers never see half a file. */
+    static bool write(const std::filesystem::path& path, const PrecompiledHeaderContents& contents,
+                      std::string_view identity);
+
+    /** @brief  The precompiled header at \c path, null when it's missing, damaged or from another \c identity. */
+    static std::shared_ptr<const PrecompiledHeader> open(const std::filesystem::path& path, std::string_view identity);
+
+    /** @brief  The header it was built from. */
+    std::filesystem::path header() const;
+
+    /** @brief  Whether every file it read still has the content it had, only the hashes are compared. */
+    bool is_current(SourceFileCache& file_cache) const;
+
+    /** @brief  The index of the macro called \c name, for the accessors below. */
+    std::optional<std::size_t> find_macro(std::string_view name) const;
+    PrecompiledMacro macro(std::size_t idx) const;
+
+    std::vector<std::string> once_files() const;
+    std::vector<Token> tokens() const;
+
+    std::size_t macro_count() const;
+
+private:
+    MappedFile file_;
+
+    explicit PrecompiledHeader(MappedFile file);
+};
+
+} // namespace billiec::scanner
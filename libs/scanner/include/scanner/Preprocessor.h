@@ -0,0 +1,97 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <scanner/PrecompiledHeader.h>
+#include <scanner/SourceFileCache.h>
+#include <scanner/Token.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace billiec::scanner {
+
+/** @brief  The C preprocessor, run over the scanner's tokens before they reach the parser.
+ *
+ * Handles #include, object and function-like #define, #undef, #if/#ifdef/#ifndef/#elif/#else/
+ * #endif, #pragma once and #error.  Included files come from a SourceFileCache, so each is read
+ * and scanned once per process.  A file that was marked #pragma once, or whose include guard
+ * macro is already defined, is skipped without walking its tokens.  The # and ## operators
+ * aren't supported.  One Preprocessor handles one translation unit.
+ *
+ * A precompiled header stands in for preprocessing its header: its macros are looked up in the
+ * mapped file when first used and only then copied in, a #define or #undef still overrides them.
+ */
+class Preprocessor {
+public:
+    Preprocessor(SourceFileCache& file_cache, std::vector<std::filesystem::path> include_directories = {});
+
+    /** @brief  Defines \c name as the tokens of \c body, what -D does. */
+    void define(const std::string& name, const std::string& body);
+
+    /** @brief  Preprocesses \c header ahead of the main file, the tokens it leaves come first. */
+    void include(const std::filesystem::path& header);
+
+    /** @brief  Takes the macros and tokens of a precompiled header as if its header had been included. */
+    void use_precompiled_header(std::shared_ptr<const PrecompiledHeader> precompiled_header);
+
+    /** @brief  Preprocesses a main file's tokens, quoted includes are looked up next to \c file first. */
+    std::vector<Token> preprocess(const std::vector<Token>& tokens, const std::filesystem::path& file);
+
+    /** @brief  What preprocessing \c header left, for writing a precompiled header. */
+    PrecompiledHeaderContents precompiled_header(const std::filesystem::path& header,
+                                                 std::vector<Token> tokens) const;
+
+    /** @brief  How many #include lines were skipped thanks to #pragma once or an include guard. */
+    std::size_t skipped_includes() const {
+        return skipped_includes_;
+    }
+
+private:
+    struct Macro {
+        bool function_like{false};
+        std::vector<std::string> parameters;
+        std::vector<Token> body;
+    };
+
+    struct Conditional {
+        bool parent_active{true};
+        bool active{true};
+        bool taken{false};      ///< Some branch of this #if has been taken already.
+        bool seen_else{false};
+    };
+
+    SourceFileCache& file_cache_;
+    std::vector<std::filesystem::path> include_directories_;
+    std::unordered_map<std::string, Macro> macros_;
+    std::unordered_set<std::string> once_files_;
+    std::vector<Conditional> conditionals_;
+    std::vector<std::string> expanding_;        ///< Macros being expanded, they don't expand again inside themselves.
+    std::vector<Token> output_;
+    std::vector<std::shared_ptr<const SourceFile>> included_files_;
+    std::shared_ptr<const PrecompiledHeader> precompiled_header_;
+    std::unordered_set<std::string> precompiled_undefined_;   ///< Macros of the precompiled header #undef'd since.
+    int include_depth_{0};
+    std::size_t skipped_includes_{0};
+
+    bool active_() const;
+    const Macro* find_macro_(const std::string& name);
+    void process_(std::span<const Token> tokens, const std::filesystem::path& file);
+    void directive_(const Token& token, const std::filesystem::path& file);
+    void include_(std::string_view operand, const Token& token, const std::filesystem::path& file);
+    void define_(std::string_view operand, const Token& token);
+    bool evaluate_(std::string_view expression, const Token& token);
+    std::size_t expand_(std::span<const Token> tokens, std::size_t idx, std::vector<Token>& out);
+    void expand_all_(std::span<const Token> tokens, std::vector<Token>& out);
+    std::size_t call_from_expansion_(std::span<const Token> tokens, std::size_t next, std::string_view expanded_name,
+                                     std::size_t expanded_from, std::vector<Token>& out);
+    std::size_t collect_arguments_(std::span<const Token> tokens, std::size_t open_paren,
+                                   std::vector<std::vector<Token>>& arguments);
+};
+
+} // namespace billiec::scanner
@@ -1,6 +1,7 @@
 // Copyright 2025 Yasser Zabuair.  See LICENSE for details.
 #pragma once
 
+#include <core/Diagnostics.h>
 #include <core/ErrorHelpers.h>
 
 #include <exception>
@@ -11,10 +12,12 @@ namespace billiec::scanner {
 
 struct ScannerError: public std::exception {
     ErrorCode ec;
+    Diagnostic diagnostic;      ///< The same problem for a Diagnostics, the file is filled in on the way out.
     mutable std::string message;
 
-    ScannerError(ErrorCode ec):
-        ec{std::move(ec)} {
+    ScannerError(ErrorCode ec, Diagnostic diagnostic):
+        ec{std::move(ec)},
+        diagnostic{std::move(diagnostic)} {
     }
     
     const char* what() const noexcept override {
@@ -0,0 +1,68 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <scanner/Token.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace billiec::scanner {
+
+/** @brief  A source file read and scanned once, what the preprocessor includes. */
+struct SourceFile {
+    std::filesystem::path path;         ///< Canonical, so every spelling of it is the same file.
+    std::vector<Token> tokens;
+    std::string include_guard;          ///< The macro an #ifndef around the whole file tests, empty when there's none.
+    std::uint64_t content_hash{0};      ///< Hash of the bytes read, what precompiled headers are checked against.
+};
+
+/** @brief  Memoizes source files by path, shared by every translation unit in the process.
+ *
+ * A file is read and scanned the first time it's asked for and handed out as is after that, as
+ * long as its size and modification time stay the same.  Safe to use from several threads.
+ */
+class SourceFileCache {
+public:
+    /** @brief  The file at \c path, null when it can't be read. */
+    std::shared_ptr<const SourceFile> get(const std::filesystem::path& path);
+
+    /** @brief  The content hash of the file at \c path without scanning it, nothing when it can't be read. */
+    std::optional<std::uint64_t> content_hash(const std::filesystem::path& path);
+
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const SourceFile> file;
+        std::uintmax_t size{0};
+        std::filesystem::file_time_type mtime;
+    };
+
+    struct HashEntry {
+        std::uint64_t content_hash{0};
+        std::uintmax_t size{0};
+        std::filesystem::file_time_type mtime;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> files_;
+    std::unordered_map<std::string, HashEntry> hashes_;
+    std::uint64_t hits_{0};
+    std::uint64_t misses_{0};
+};
+
+/** @brief  Splits directive text into its name and the trimmed rest, "define X 1" gives "define" and "X 1". */
+std::pair<std::string_view, std::string_view> split_directive(std::string_view text);
+
+/** @brief  The include guard of a scanned file, the #ifndef macro when its #endif is the last token. */
+std::string find_include_guard(const std::vector<Token>& tokens);
+
+} // namespace billiec::scanner
@@ -3,6 +3,7 @@
 
 #include <scanner/TokenType.h>
 
+#include <cstdint>
 #include <string>
 #include <variant>
 
@@ -16,6 +17,7 @@ struct Token {
     TokenValueType  token_value;
     std::string     lexeme;
     int             line{0};
+    std::uint32_t   offset{0};      ///< Where in the scanned source it starts, in bytes.
 };
 
 inline std::ostream& operator<<(std::ostream& ostream, const TokenValueType& value) {
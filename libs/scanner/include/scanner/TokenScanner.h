@@ -1,6 +1,8 @@
 // Copyright 2025, Yasser Zabuair.  See LICENSE for details.
 #pragma once
+#include <core/Diagnostics.h>
 #include <core/ErrorHelpers.h>
+#include <scanner/Errors.h>
 #include <scanner/Token.h>
 
 #include <expected>
@@ -18,6 +20,8 @@ private:
     int                 start_{0};
     int                 current_{0};
     int                 curr_line_{1};
+    bool                at_line_start_{true};   ///< Nothing but whitespace so far on this line.
+    Diagnostics         diagnostics_;
     const std::map<std::string, TokenType> keywords_ = {
         {"and", TokenType::AND},
         {"else", TokenType::ELSE},
@@ -36,6 +40,11 @@ private:
     
 public:
     TokenScanner(std::string inp_source);
+    
+    /** @brief  Scans the whole source, going on past bad characters so every one of them is reported. */
+    std::expected<std::vector<Token>, Diagnostics> scan();
+    
+    /** @brief  The same as \c scan, but throws a ScannerError for the first problem. */
     std::vector<Token> get_tokens();
     
 private:
@@ -45,6 +54,12 @@ private:
     void number_();
     void string_();
     void identifier_();
+    void directive_();
+    void line_comment_();
+    void block_comment_();
+    bool match_(char expected);
+    void error_(errc code, const char* message);
+    void error_(errc code, const char* message, int offset, int length, int line);
     void add_token_(TokenType type);
     void add_token_(TokenType type, const TokenValueType& value);
     char advance_();
@@ -10,11 +10,12 @@ enum class TokenType {
 
     // Single-character tokens.
     LEFT_PAREN, RIGHT_PAREN, LEFT_BRACE, RIGHT_BRACE,
-    COMMA, DOT, MINUS, PLUS, SEMICOLON, SLASH, STAR,
+    COMMA, DOT, MINUS, PLUS, SEMICOLON, SLASH, STAR, PERCENT,
 
     // One or two character tokens.
     BANG, BANG_EQUAL, EQUAL, EQUAL_EQUAL,
     GREATER, GREATER_EQUAL, LESS, LESS_EQUAL, COMPLEMENT,
+    AMP_AMP, PIPE_PIPE,
 
     // Literals.
     IDENTIFIER, STRING, NUMBER,
@@ -23,6 +24,9 @@ enum class TokenType {
     AND, ELSE, FALSE, FUN, FOR, IF, OR,
     PRINT, RETURN, TRUE, WHILE, INT, VOID,
 
+    // A whole preprocessor line, the text after the '#' is the token's value.
+    DIRECTIVE,
+
     NEWLINE, ENDOFFILE
 };
 
@@ -64,6 +68,9 @@ inline std::ostream& operator<<(std::ostream& ostream, const TokenType& type) {
         case TokenType::STAR:
             ostream << "STAR";
             break;
+        case TokenType::PERCENT:
+            ostream << "PERCENT";
+            break;
         case TokenType::BANG:
             ostream << "!";
             break;
@@ -91,6 +98,12 @@ inline std::ostream& operator<<(std::ostream& ostream, const TokenType& type) {
         case TokenType::COMPLEMENT:
             ostream << "~";
             break;
+        case TokenType::AMP_AMP:
+            ostream << "&&";
+            break;
+        case TokenType::PIPE_PIPE:
+            ostream << "||";
+            break;
         case TokenType::IDENTIFIER:
             ostream << "IDENTIFIER";
             break;
@@ -133,6 +146,9 @@ inline std::ostream& operator<<(std::ostream& ostream, const TokenType& type) {
         case TokenType::VOID:
             ostream << "VOID";
             break;
+        case TokenType::DIRECTIVE:
+            ostream << "DIRECTIVE";
+            break;
         default:
             ostream << "UNKNOWN";
             break;
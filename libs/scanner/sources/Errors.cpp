@@ -23,6 +23,24 @@ struct ErrorCategory: public std::error_category
                 return "scanner_err_none";
             case errc::scanner_err_invalid_token:
                 return "scanner_err_invalid_token";
+            case errc::scanner_err_unterminated_comment:
+                return "scanner_err_unterminated_comment";
+            case errc::scanner_err_number_out_of_range:
+                return "scanner_err_number_out_of_range";
+            case errc::preprocessor_err_bad_directive:
+                return "preprocessor_err_bad_directive";
+            case errc::preprocessor_err_include_not_found:
+                return "preprocessor_err_include_not_found";
+            case errc::preprocessor_err_include_depth:
+                return "preprocessor_err_include_depth";
+            case errc::preprocessor_err_unbalanced_conditional:
+                return "preprocessor_err_unbalanced_conditional";
+            case errc::preprocessor_err_macro_arguments:
+                return "preprocessor_err_macro_arguments";
+            case errc::preprocessor_err_bad_expression:
+                return "preprocessor_err_bad_expression";
+            case errc::preprocessor_err_error_directive:
+                return "preprocessor_err_error_directive";
             default:
                 return "Unknown Error";
         }
@@ -0,0 +1,387 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <scanner/PrecompiledHeader.h>
+
+#include <core/Hash.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <thread>
+#include <type_traits>
+
+namespace billiec::scanner {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr char magic[8] = {'B', 'I', 'L', 'L', 'P', 'C', 'H', '\0'};
+constexpr std::uint32_t format_version = 1;
+
+// Everything is in host byte order, a precompiled header is only ever read where it was built.
+struct StringRef {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct DependencyRecord {
+    StringRef path;
+    std::uint64_t content_hash;
+};
+
+struct MacroRecord {
+    StringRef name;
+    std::uint32_t function_like;
+    std::uint32_t first_parameter;
+    std::uint32_t parameter_count;
+    std::uint32_t first_token;
+    std::uint32_t token_count;
+};
+
+enum class ValueKind : std::uint32_t {
+    none,
+    integer,
+    string,
+    boolean,
+    null
+};
+
+struct TokenRecord {
+    std::uint32_t type;
+    ValueKind value_kind;
+    std::int32_t int_value;
+    std::int32_t line;
+    StringRef lexeme;
+    StringRef string_value;
+};
+
+/** @brief  One of the record arrays, where it starts in the file and how many records it holds. */
+struct Section {
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t identity_hash;
+    StringRef header_path;
+    std::uint32_t output_first;         ///< The header's own tokens, after every macro body in the token section.
+    std::uint32_t output_count;
+    Section dependencies;
+    Section macros;
+    Section buckets;                    ///< Open addressing over the macro names, macro index + 1, 0 for empty.
+    Section parameters;
+    Section tokens;
+    Section once_files;
+    Section strings;
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<TokenRecord>);
+
+// Records sit at multiples of eight so they can be read in place from the page-aligned mapping.
+constexpr std::uint64_t section_alignment = 8;
+
+std::uint64_t macro_bucket(std::string_view name, std::uint64_t bucket_count) {
+    return hash_bytes(name) & (bucket_count - 1);
+}
+
+/** @brief  Lays the records out in memory the way they go on disk. */
+class PrecompiledHeaderWriter {
+public:
+    std::string write(const PrecompiledHeaderContents& contents, std::string_view identity) {
+        FileHeader header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = format_version;
+        header.identity_hash = hash_bytes(identity);
+        header.header_path = string_(contents.header.string());
+
+        for(const auto& [curr_path, curr_hash]: contents.dependencies) {
+            dependencies_.push_back({string_(curr_path), curr_hash});
+        }
+        for(const auto& curr_macro: contents.macros) {
+            MacroRecord record{};
+            record.name = string_(curr_macro.name);
+            record.function_like = curr_macro.function_like ? 1 : 0;
+            record.first_parameter = static_cast<std::uint32_t>(parameters_.size());
+            record.parameter_count = static_cast<std::uint32_t>(curr_macro.parameters.size());
+            for(const auto& curr_parameter: curr_macro.parameters) {
+                parameters_.push_back(string_(curr_parameter));
+            }
+            record.first_token = static_cast<std::uint32_t>(tokens_.size());
+            record.token_count = static_cast<std::uint32_t>(curr_macro.body.size());
+            for(const auto& curr_token: curr_macro.body) {
+                tokens_.push_back(token_(curr_token));
+            }
+            macros_.push_back(record);
+        }
+        header.output_first = static_cast<std::uint32_t>(tokens_.size());
+        header.output_count = static_cast<std::uint32_t>(contents.tokens.size());
+        for(const auto& curr_token: contents.tokens) {
+            tokens_.push_back(token_(curr_token));
+        }
+        for(const auto& curr_file: contents.once_files) {
+            once_files_.push_back(string_(curr_file));
+        }
+
+        // At most half full keeps the probe sequences short.
+        std::vector<std::uint32_t> buckets(contents.macros.empty() ? 0 : std::bit_ceil(contents.macros.size() * 2));
+        for(std::size_t idx = 0; idx < contents.macros.size(); ++idx) {
+            auto bucket = macro_bucket(contents.macros[idx].name, buckets.size());
+            while(buckets[bucket] != 0) {
+                bucket = (bucket + 1) & (buckets.size() - 1);
+            }
+            buckets[bucket] = static_cast<std::uint32_t>(idx + 1);
+        }
+
+        std::string out(sizeof(FileHeader), '\0');
+        header.dependencies = append_(out, dependencies_);
+        header.macros = append_(out, macros_);
+        header.buckets = append_(out, buckets);
+        header.parameters = append_(out, parameters_);
+        header.tokens = append_(out, tokens_);
+        header.once_files = append_(out, once_files_);
+        header.strings = {out.size(), strings_.size()};
+        out += strings_;
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+
+private:
+    std::string strings_;
+    std::vector<DependencyRecord> dependencies_;
+    std::vector<MacroRecord> macros_;
+    std::vector<StringRef> parameters_;
+    std::vector<TokenRecord> tokens_;
+    std::vector<StringRef> once_files_;
+
+    StringRef string_(std::string_view text) {
+        StringRef ref{static_cast<std::uint32_t>(strings_.size()), static_cast<std::uint32_t>(text.size())};
+        strings_ += text;
+        return ref;
+    }
+
+    TokenRecord token_(const Token& token) {
+        TokenRecord record{};
+        record.type = static_cast<std::uint32_t>(token.token_type);
+        record.line = token.line;
+        record.lexeme = string_(token.lexeme);
+        if (const auto* value = std::get_if<int>(&token.token_value)) {
+            record.value_kind = ValueKind::integer;
+            record.int_value = *value;
+        } else if (const auto* value = std::get_if<std::string>(&token.token_value)) {
+            // Identifiers carry their lexeme as their value, there's no need to store it twice.
+            record.value_kind = ValueKind::string;
+            record.string_value = *value == token.lexeme ? record.lexeme : string_(*value);
+        } else if (const auto* value = std::get_if<bool>(&token.token_value)) {
+            record.value_kind = ValueKind::boolean;
+            record.int_value = *value ? 1 : 0;
+        } else if (std::holds_alternative<nullptr_t>(token.token_value)) {
+            record.value_kind = ValueKind::null;
+        }
+        return record;
+    }
+
+    template<typename Record>
+    static Section append_(std::string& out, const std::vector<Record>& records) {
+        out.resize((out.size() + section_alignment - 1) / section_alignment * section_alignment, '\0');
+        Section section{out.size(), records.size()};
+        out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+        return section;
+    }
+};
+
+const FileHeader& file_header(const MappedFile& file) {
+    return *reinterpret_cast<const FileHeader*>(file.bytes().data());
+}
+
+template<typename Record>
+std::span<const Record> records(const MappedFile& file, const Section& section) {
+    return {reinterpret_cast<const Record*>(file.bytes().data() + section.offset), section.count};
+}
+
+template<typename Record>
+bool section_fits(const MappedFile& file, const Section& section) {
+    return section.offset % section_alignment == 0 &&
+           section.offset <= file.bytes().size() &&
+           section.count <= (file.bytes().size() - section.offset) / sizeof(Record);
+}
+
+// Strings are checked as they're read, a damaged reference reads as empty rather than past the end.
+std::string_view string_at(const MappedFile& file, StringRef ref) {
+    const auto& strings = file_header(file).strings;
+    if (static_cast<std::uint64_t>(ref.offset) + ref.length > strings.count) {
+        return {};
+    }
+    return file.bytes().substr(strings.offset + ref.offset, ref.length);
+}
+
+Token to_token(const MappedFile& file, const TokenRecord& record) {
+    Token token{
+        .token_type = static_cast<TokenType>(record.type),
+        .token_value = TokenValueType{},
+        .lexeme = std::string{string_at(file, record.lexeme)},
+        .line = record.line
+    };
+    switch(record.value_kind) {
+        case ValueKind::integer:
+            token.token_value = record.int_value;
+            break;
+        case ValueKind::string:
+            token.token_value = std::string{string_at(file, record.string_value)};
+            break;
+        case ValueKind::boolean:
+            token.token_value = record.int_value != 0;
+            break;
+        case ValueKind::null:
+            token.token_value = nullptr;
+            break;
+        case ValueKind::none:
+            break;
+    }
+    return token;
+}
+
+std::vector<Token> token_range(const MappedFile& file, std::uint64_t first, std::uint64_t count) {
+    auto all = records<TokenRecord>(file, file_header(file).tokens);
+    std::vector<Token> tokens;
+    if (first > all.size() || count > all.size() - first) {
+        return tokens;
+    }
+    tokens.reserve(count);
+    for(const auto& curr_record: all.subspan(first, count)) {
+        tokens.push_back(to_token(file, curr_record));
+    }
+    return tokens;
+}
+
+} // namespace
+
+bool PrecompiledHeader::write(const fs::path& path, const PrecompiledHeaderContents& contents,
+                              std::string_view identity) {
+    auto bytes = PrecompiledHeaderWriter{}.write(contents, identity);
+
+    auto temporary = path;
+    temporary += ".tmp." + std::to_string(::getpid()) + "." +
+                 std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    std::error_code ec;
+    {
+        std::ofstream stream{temporary, std::ios::binary | std::ios::trunc};
+        stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!stream.flush()) {
+            stream.close();
+            fs::remove(temporary, ec);
+            return false;
+        }
+    }
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const PrecompiledHeader> PrecompiledHeader::open(const fs::path& path, std::string_view identity) {
+    auto file = MappedFile::open(path);
+    if (!file || file->bytes().size() < sizeof(FileHeader)) {
+        return nullptr;
+    }
+
+    const auto& header = file_header(*file);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+        header.version != format_version ||
+        header.identity_hash != hash_bytes(identity) ||
+        !section_fits<DependencyRecord>(*file, header.dependencies) ||
+        !section_fits<MacroRecord>(*file, header.macros) ||
+        !section_fits<std::uint32_t>(*file, header.buckets) ||
+        !section_fits<StringRef>(*file, header.parameters) ||
+        !section_fits<TokenRecord>(*file, header.tokens) ||
+        !section_fits<StringRef>(*file, header.once_files) ||
+        !section_fits<char>(*file, header.strings) ||
+        !std::has_single_bit(header.buckets.count | (header.macros.count == 0 ? 1 : 0)) ||
+        header.buckets.count < header.macros.count) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const PrecompiledHeader>{new PrecompiledHeader{std::move(*file)}};
+}
+
+PrecompiledHeader::PrecompiledHeader(MappedFile file):
+    file_{std::move(file)} {
+}
+
+fs::path PrecompiledHeader::header() const {
+    return fs::path{string_at(file_, file_header(file_).header_path)};
+}
+
+bool PrecompiledHeader::is_current(SourceFileCache& file_cache) const {
+    for(const auto& curr_dependency: records<DependencyRecord>(file_, file_header(file_).dependencies)) {
+        auto content_hash = file_cache.content_hash(fs::path{string_at(file_, curr_dependency.path)});
+        if (content_hash != curr_dependency.content_hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<std::size_t> PrecompiledHeader::find_macro(std::string_view name) const {
+    auto buckets = records<std::uint32_t>(file_, file_header(file_).buckets);
+    auto macros = records<MacroRecord>(file_, file_header(file_).macros);
+    if (buckets.empty()) {
+        return std::nullopt;
+    }
+
+    // The table is never full, so the probe always ends at an empty bucket.
+    auto bucket = macro_bucket(name, buckets.size());
+    for(std::size_t probes = 0; probes < buckets.size() && buckets[bucket] != 0; ++probes) {
+        auto idx = buckets[bucket] - 1;
+        if (idx < macros.size() && string_at(file_, macros[idx].name) == name) {
+            return idx;
+        }
+        bucket = (bucket + 1) & (buckets.size() - 1);
+    }
+    return std::nullopt;
+}
+
+PrecompiledMacro PrecompiledHeader::macro(std::size_t idx) const {
+    const auto& record = records<MacroRecord>(file_, file_header(file_).macros)[idx];
+    auto parameters = records<StringRef>(file_, file_header(file_).parameters);
+
+    PrecompiledMacro macro;
+    macro.name = string_at(file_, record.name);
+    macro.function_like = record.function_like != 0;
+    if (record.first_parameter <= parameters.size() &&
+        record.parameter_count <= parameters.size() - record.first_parameter) {
+        for(const auto& curr_parameter: parameters.subspan(record.first_parameter, record.parameter_count)) {
+            macro.parameters.emplace_back(string_at(file_, curr_parameter));
+        }
+    }
+    macro.body = token_range(file_, record.first_token, record.token_count);
+    return macro;
+}
+
+std::vector<std::string> PrecompiledHeader::once_files() const {
+    std::vector<std::string> files;
+    for(const auto& curr_file: records<StringRef>(file_, file_header(file_).once_files)) {
+        files.emplace_back(string_at(file_, curr_file));
+    }
+    return files;
+}
+
+std::vector<Token> PrecompiledHeader::tokens() const {
+    const auto& header = file_header(file_);
+    return token_range(file_, header.output_first, header.output_count);
+}
+
+std::size_t PrecompiledHeader::macro_count() const {
+    return file_header(file_).macros.count;
+}
+
+} // namespace billiec::scanner
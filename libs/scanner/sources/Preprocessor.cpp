@@ -0,0 +1,646 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <scanner/Preprocessor.h>
+
+#include <scanner/Errors.h>
+#include <scanner/ScannerError.h>
+#include <scanner/TokenScanner.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace billiec::scanner {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Deep enough for any real include chain, shallow enough to catch a file including itself.
+constexpr int max_include_depth = 200;
+
+[[noreturn]] void fail(errc code, const char* what, const Token& token, std::string_view detail = {}) {
+    auto ec = ErrorCode{make_error_code(code), what};
+    ec << "line: " << token.line;
+    if (!detail.empty()) {
+        ec << ", " << detail;
+    }
+    throw ScannerError{ec, Diagnostic{
+        .code = ec.ec_,
+        .message = what,
+        .offset = token.offset,
+        .line = token.line,
+        .detail = std::string{detail}
+    }};
+}
+
+bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+std::string_view identifier_prefix(std::string_view text) {
+    std::size_t end = 0;
+    while(end < text.size() && is_identifier_char(text[end]) && !(end == 0 && std::isdigit(static_cast<unsigned char>(text[0])))) {
+        ++end;
+    }
+    return text.substr(0, end);
+}
+
+std::string_view trim(std::string_view text) {
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Keywords are identifiers as far as #if goes.
+bool is_identifier_like(const Token& token) {
+    return !token.lexeme.empty() && (std::isalpha(static_cast<unsigned char>(token.lexeme[0])) || token.lexeme[0] == '_');
+}
+
+Token number_token(long long value, int line) {
+    return Token{
+        .token_type = TokenType::NUMBER,
+        .token_value = static_cast<int>(value),
+        .lexeme = std::to_string(value),
+        .line = line
+    };
+}
+
+/** @brief  Evaluates the expression of an #if once macros are expanded, by recursive descent. */
+class ConditionEvaluator {
+public:
+    ConditionEvaluator(std::span<const Token> tokens, const Token& directive):
+        tokens_{tokens},
+        directive_{directive} {
+    }
+
+    long long evaluate() {
+        auto value = logical_or_();
+        if (pos_ != tokens_.size()) {
+            fail(errc::preprocessor_err_bad_expression, "Unexpected token in #if", directive_, tokens_[pos_].lexeme);
+        }
+        return value;
+    }
+
+private:
+    std::span<const Token> tokens_;
+    const Token& directive_;
+    std::size_t pos_{0};
+
+    bool match_(TokenType type) {
+        if (pos_ < tokens_.size() && tokens_[pos_].token_type == type) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    long long logical_or_() {
+        auto value = logical_and_();
+        while(match_(TokenType::PIPE_PIPE)) {
+            auto rhs = logical_and_();
+            value = (value != 0 || rhs != 0) ? 1 : 0;
+        }
+        return value;
+    }
+
+    long long logical_and_() {
+        auto value = equality_();
+        while(match_(TokenType::AMP_AMP)) {
+            auto rhs = equality_();
+            value = (value != 0 && rhs != 0) ? 1 : 0;
+        }
+        return value;
+    }
+
+    long long equality_() {
+        auto value = relational_();
+        while(true) {
+            if (match_(TokenType::EQUAL_EQUAL)) {
+                value = value == relational_() ? 1 : 0;
+            } else if (match_(TokenType::BANG_EQUAL)) {
+                value = value != relational_() ? 1 : 0;
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long relational_() {
+        auto value = additive_();
+        while(true) {
+            if (match_(TokenType::LESS)) {
+                value = value < additive_() ? 1 : 0;
+            } else if (match_(TokenType::LESS_EQUAL)) {
+                value = value <= additive_() ? 1 : 0;
+            } else if (match_(TokenType::GREATER)) {
+                value = value > additive_() ? 1 : 0;
+            } else if (match_(TokenType::GREATER_EQUAL)) {
+                value = value >= additive_() ? 1 : 0;
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long additive_() {
+        auto value = multiplicative_();
+        while(true) {
+            if (match_(TokenType::PLUS)) {
+                value += multiplicative_();
+            } else if (match_(TokenType::MINUS)) {
+                value -= multiplicative_();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long multiplicative_() {
+        auto value = unary_();
+        while(true) {
+            if (match_(TokenType::STAR)) {
+                value *= unary_();
+            } else if (match_(TokenType::SLASH) || match_(TokenType::PERCENT)) {
+                bool is_division = tokens_[pos_ - 1].token_type == TokenType::SLASH;
+                auto rhs = unary_();
+                if (rhs == 0) {
+                    fail(errc::preprocessor_err_bad_expression, "Division by zero in #if", directive_);
+                }
+                value = is_division ? value / rhs : value % rhs;
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long unary_() {
+        if (match_(TokenType::MINUS)) {
+            return -unary_();
+        }
+        if (match_(TokenType::PLUS)) {
+            return unary_();
+        }
+        if (match_(TokenType::COMPLEMENT)) {
+            return ~unary_();
+        }
+        if (match_(TokenType::BANG)) {
+            return unary_() == 0 ? 1 : 0;
+        }
+        return primary_();
+    }
+
+    long long primary_() {
+        if (pos_ >= tokens_.size()) {
+            fail(errc::preprocessor_err_bad_expression, "#if expression ends early", directive_);
+        }
+        const auto& token = tokens_[pos_];
+        if (token.token_type == TokenType::NUMBER) {
+            ++pos_;
+            return std::get<int>(token.token_value);
+        }
+        if (match_(TokenType::LEFT_PAREN)) {
+            auto value = logical_or_();
+            if (!match_(TokenType::RIGHT_PAREN)) {
+                fail(errc::preprocessor_err_bad_expression, "Missing ')' in #if", directive_);
+            }
+            return value;
+        }
+        if (is_identifier_like(token)) {
+            // Whatever is left after expansion isn't a macro, it counts as 0.
+            ++pos_;
+            return 0;
+        }
+        fail(errc::preprocessor_err_bad_expression, "Unexpected token in #if", directive_, token.lexeme);
+    }
+};
+
+} // namespace
+
+Preprocessor::Preprocessor(SourceFileCache& file_cache, std::vector<fs::path> include_directories):
+    file_cache_{file_cache},
+    include_directories_{std::move(include_directories)} {
+}
+
+void Preprocessor::define(const std::string& name, const std::string& body) {
+    Macro macro;
+    macro.body = TokenScanner{body}.get_tokens();
+    macros_[name] = std::move(macro);
+    precompiled_undefined_.erase(name);
+}
+
+void Preprocessor::include(const fs::path& header) {
+    auto included = file_cache_.get(header);
+    if (!included) {
+        auto ec = ErrorCode{make_error_code(errc::preprocessor_err_include_not_found), "Include file not found"};
+        ec << header.string();
+        throw ScannerError{ec, Diagnostic{.code = ec.ec_, .message = "Include file not found", .detail = header.string()}};
+    }
+    included_files_.push_back(included);
+    process_(included->tokens, included->path);
+}
+
+void Preprocessor::use_precompiled_header(std::shared_ptr<const PrecompiledHeader> precompiled_header) {
+    for(auto& curr_file: precompiled_header->once_files()) {
+        once_files_.insert(std::move(curr_file));
+    }
+    auto tokens = precompiled_header->tokens();
+    output_.insert(output_.end(), tokens.begin(), tokens.end());
+    precompiled_header_ = std::move(precompiled_header);
+}
+
+std::vector<Token> Preprocessor::preprocess(const std::vector<Token>& tokens, const fs::path& file) {
+    output_.reserve(output_.size() + tokens.size());
+    process_(tokens, file);
+    return std::move(output_);
+}
+
+PrecompiledHeaderContents Preprocessor::precompiled_header(const fs::path& header, std::vector<Token> tokens) const {
+    PrecompiledHeaderContents contents;
+    contents.header = header;
+    for(const auto& curr_file: included_files_) {
+        auto path = curr_file->path.string();
+        auto seen = std::find_if(contents.dependencies.begin(), contents.dependencies.end(),
+                                 [&path](const auto& dependency) { return dependency.first == path; });
+        if (seen == contents.dependencies.end()) {
+            contents.dependencies.emplace_back(std::move(path), curr_file->content_hash);
+        }
+    }
+    for(const auto& [curr_name, curr_macro]: macros_) {
+        contents.macros.push_back({curr_name, curr_macro.function_like, curr_macro.parameters, curr_macro.body});
+    }
+    // Hash order would make the same header give different files.
+    std::sort(contents.macros.begin(), contents.macros.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.name < rhs.name; });
+    contents.once_files.assign(once_files_.begin(), once_files_.end());
+    std::sort(contents.once_files.begin(), contents.once_files.end());
+    contents.tokens = std::move(tokens);
+    return contents;
+}
+
+bool Preprocessor::active_() const {
+    return conditionals_.empty() || conditionals_.back().active;
+}
+
+const Preprocessor::Macro* Preprocessor::find_macro_(const std::string& name) {
+    auto itr = macros_.find(name);
+    if (itr != macros_.end()) {
+        return &itr->second;
+    }
+    if (!precompiled_header_ || precompiled_undefined_.contains(name)) {
+        return nullptr;
+    }
+
+    // First use of a precompiled macro, copy it out of the mapping once.
+    auto idx = precompiled_header_->find_macro(name);
+    if (!idx) {
+        return nullptr;
+    }
+    auto precompiled = precompiled_header_->macro(*idx);
+    auto& macro = macros_[name];
+    macro.function_like = precompiled.function_like;
+    macro.parameters = std::move(precompiled.parameters);
+    macro.body = std::move(precompiled.body);
+    return &macro;
+}
+
+void Preprocessor::process_(std::span<const Token> tokens, const fs::path& file) {
+    // Conditionals can't start in one file and end in another.
+    auto base_depth = conditionals_.size();
+    std::size_t idx = 0;
+    try {
+        while(idx < tokens.size()) {
+            const auto& token = tokens[idx];
+            if (token.token_type == TokenType::DIRECTIVE) {
+                if (split_directive(std::get<std::string>(token.token_value)).first == "endif" &&
+                    conditionals_.size() <= base_depth) {
+                    fail(errc::preprocessor_err_unbalanced_conditional, "#endif without #if", token);
+                }
+                directive_(token, file);
+                ++idx;
+            } else if (!active_()) {
+                ++idx;
+            } else {
+                idx = expand_(tokens, idx, output_);
+            }
+        }
+
+        if (conditionals_.size() != base_depth) {
+            fail(errc::preprocessor_err_unbalanced_conditional, "#if without #endif", tokens.back(), file.string());
+        }
+    } catch (ScannerError& error) {
+        // The innermost file the error passes through is the one its line is in.
+        if (error.diagnostic.file.empty()) {
+            error.diagnostic.file = file.string();
+        }
+        throw;
+    }
+}
+
+void Preprocessor::directive_(const Token& token, const fs::path& file) {
+    auto [name, operand] = split_directive(std::get<std::string>(token.token_value));
+
+    if (name == "if" || name == "ifdef" || name == "ifndef") {
+        // Inside a skipped region nothing is evaluated, only the nesting is tracked.
+        bool parent_active = active_();
+        bool condition = false;
+        if (parent_active && name == "if") {
+            condition = evaluate_(operand, token);
+        } else if (parent_active) {
+            auto macro = identifier_prefix(operand);
+            if (macro.empty()) {
+                fail(errc::preprocessor_err_bad_directive, "Missing macro name", token, name);
+            }
+            condition = (find_macro_(std::string{macro}) != nullptr) == (name == "ifdef");
+        }
+        conditionals_.push_back({parent_active, condition, condition, false});
+        return;
+    }
+
+    if (name == "elif" || name == "else") {
+        if (conditionals_.empty() || conditionals_.back().seen_else) {
+            fail(errc::preprocessor_err_unbalanced_conditional, "Stray directive", token, name);
+        }
+        auto& conditional = conditionals_.back();
+        if (!conditional.parent_active || conditional.taken) {
+            conditional.active = false;
+        } else {
+            conditional.active = name == "else" || evaluate_(operand, token);
+        }
+        conditional.taken = conditional.taken || conditional.active;
+        conditional.seen_else = name == "else";
+        return;
+    }
+
+    if (name == "endif") {
+        conditionals_.pop_back();
+        return;
+    }
+
+    if (!active_()) {
+        return;
+    }
+
+    if (name.empty() || name == "line" || name == "warning") {
+        // The null directive, and the ones that don't change the tokens.
+        return;
+    } else if (name == "include") {
+        include_(operand, token, file);
+    } else if (name == "define") {
+        define_(operand, token);
+    } else if (name == "undef") {
+        std::string macro{identifier_prefix(operand)};
+        macros_.erase(macro);
+        if (precompiled_header_) {
+            precompiled_undefined_.insert(std::move(macro));
+        }
+    } else if (name == "pragma") {
+        if (identifier_prefix(operand) == "once") {
+            once_files_.insert(file.string());
+        }
+    } else if (name == "error") {
+        fail(errc::preprocessor_err_error_directive, "#error", token, operand);
+    } else {
+        fail(errc::preprocessor_err_bad_directive, "Unknown directive", token, name);
+    }
+}
+
+void Preprocessor::include_(std::string_view operand, const Token& token, const fs::path& file) {
+    if (operand.empty() || (operand.front() != '"' && operand.front() != '<')) {
+        fail(errc::preprocessor_err_bad_directive, "Expected \"file\" or <file> after #include", token, operand);
+    }
+    char close = operand.front() == '"' ? '"' : '>';
+    auto end = operand.find(close, 1);
+    if (end == std::string_view::npos) {
+        fail(errc::preprocessor_err_bad_directive, "Unterminated file name in #include", token, operand);
+    }
+    std::string name{operand.substr(1, end - 1)};
+
+    // Quoted names look next to the including file first, then both forms go through -I.
+    std::shared_ptr<const SourceFile> included;
+    if (close == '"') {
+        included = file_cache_.get(file.parent_path() / name);
+    }
+    for(const auto& curr_directory: include_directories_) {
+        if (included) {
+            break;
+        }
+        included = file_cache_.get(curr_directory / name);
+    }
+    if (!included) {
+        fail(errc::preprocessor_err_include_not_found, "Include file not found", token, name);
+    }
+
+    if (once_files_.contains(included->path.string()) ||
+        (!included->include_guard.empty() && find_macro_(included->include_guard) != nullptr)) {
+        ++skipped_includes_;
+        return;
+    }
+
+    if (include_depth_ >= max_include_depth) {
+        fail(errc::preprocessor_err_include_depth, "#include nested too deeply", token, name);
+    }
+    ++include_depth_;
+    included_files_.push_back(included);
+    process_(included->tokens, included->path);
+    --include_depth_;
+}
+
+void Preprocessor::define_(std::string_view operand, const Token& token) {
+    auto name = identifier_prefix(operand);
+    if (name.empty()) {
+        fail(errc::preprocessor_err_bad_directive, "Missing macro name", token, "define");
+    }
+    auto rest = operand.substr(name.size());
+
+    // Only a '(' right after the name makes a function-like macro, "F (x)" is object-like.
+    Macro macro;
+    if (!rest.empty() && rest.front() == '(') {
+        auto close = rest.find(')');
+        if (close == std::string_view::npos) {
+            fail(errc::preprocessor_err_bad_directive, "Missing ')' in macro parameters", token, name);
+        }
+        macro.function_like = true;
+        auto parameters = trim(rest.substr(1, close - 1));
+        while(!parameters.empty()) {
+            auto comma = parameters.find(',');
+            auto parameter = trim(parameters.substr(0, comma));
+            if (parameter.empty() || identifier_prefix(parameter).size() != parameter.size()) {
+                fail(errc::preprocessor_err_bad_directive, "Bad macro parameter", token, parameter);
+            }
+            macro.parameters.emplace_back(parameter);
+            parameters = comma == std::string_view::npos ? std::string_view{} : trim(parameters.substr(comma + 1));
+        }
+        rest = rest.substr(close + 1);
+    }
+
+    macro.body = TokenScanner{std::string{rest}}.get_tokens();
+    macros_[std::string{name}] = std::move(macro);
+    precompiled_undefined_.erase(std::string{name});
+}
+
+bool Preprocessor::evaluate_(std::string_view expression, const Token& token) {
+    auto scanned = TokenScanner{std::string{expression}}.get_tokens();
+
+    // defined X and defined(X) are settled before expansion so the name itself isn't expanded.
+    std::vector<Token> resolved;
+    for(std::size_t idx = 0; idx < scanned.size(); ++idx) {
+        if (scanned[idx].token_type != TokenType::IDENTIFIER || scanned[idx].lexeme != "defined") {
+            resolved.push_back(scanned[idx]);
+            continue;
+        }
+        bool parenthesized = idx + 1 < scanned.size() && scanned[idx + 1].token_type == TokenType::LEFT_PAREN;
+        auto name_idx = idx + (parenthesized ? 2 : 1);
+        if (name_idx >= scanned.size() || !is_identifier_like(scanned[name_idx]) ||
+            (parenthesized && (name_idx + 1 >= scanned.size() ||
+                               scanned[name_idx + 1].token_type != TokenType::RIGHT_PAREN))) {
+            fail(errc::preprocessor_err_bad_expression, "Bad use of defined in #if", token);
+        }
+        resolved.push_back(number_token(find_macro_(scanned[name_idx].lexeme) != nullptr ? 1 : 0, token.line));
+        idx = name_idx + (parenthesized ? 1 : 0);
+    }
+
+    std::vector<Token> expanded;
+    expand_all_(resolved, expanded);
+    return ConditionEvaluator{expanded, token}.evaluate() != 0;
+}
+
+std::size_t Preprocessor::expand_(std::span<const Token> tokens, std::size_t idx, std::vector<Token>& out) {
+    const auto& token = tokens[idx];
+    if (token.token_type != TokenType::IDENTIFIER) {
+        out.push_back(token);
+        return idx + 1;
+    }
+
+    const auto* found = find_macro_(token.lexeme);
+    if (found == nullptr ||
+        std::find(expanding_.begin(), expanding_.end(), token.lexeme) != expanding_.end()) {
+        out.push_back(token);
+        return idx + 1;
+    }
+    const auto& macro = *found;
+
+    if (!macro.function_like) {
+        std::vector<Token> body = macro.body;
+        for(auto& curr_token: body) {
+            curr_token.line = token.line;
+            curr_token.offset = token.offset;
+        }
+        auto expanded_from = out.size();
+        expanding_.push_back(token.lexeme);
+        expand_all_(body, out);
+        expanding_.pop_back();
+        return call_from_expansion_(tokens, idx + 1, token.lexeme, expanded_from, out);
+    }
+
+    // A function-like macro's name without arguments is just a name.
+    if (idx + 1 >= tokens.size() || tokens[idx + 1].token_type != TokenType::LEFT_PAREN) {
+        out.push_back(token);
+        return idx + 1;
+    }
+
+    std::vector<std::vector<Token>> arguments;
+    auto next = collect_arguments_(tokens, idx + 1, arguments);
+    if (macro.parameters.empty() && arguments.size() == 1 && arguments.front().empty()) {
+        arguments.clear();
+    }
+    if (arguments.size() != macro.parameters.size()) {
+        fail(errc::preprocessor_err_macro_arguments, "Wrong number of macro arguments", token, token.lexeme);
+    }
+
+    // Arguments are expanded on their own first, then the substituted body is rescanned.
+    for(auto& curr_argument: arguments) {
+        std::vector<Token> expanded;
+        expand_all_(curr_argument, expanded);
+        curr_argument = std::move(expanded);
+    }
+
+    std::vector<Token> substituted;
+    for(const auto& curr_token: macro.body) {
+        auto parameter = curr_token.token_type == TokenType::IDENTIFIER ?
+            std::find(macro.parameters.begin(), macro.parameters.end(), curr_token.lexeme) :
+            macro.parameters.end();
+        if (parameter == macro.parameters.end()) {
+            substituted.push_back(curr_token);
+        } else {
+            const auto& argument = arguments[parameter - macro.parameters.begin()];
+            substituted.insert(substituted.end(), argument.begin(), argument.end());
+        }
+    }
+    for(auto& curr_token: substituted) {
+        curr_token.line = token.line;
+        curr_token.offset = token.offset;
+    }
+
+    auto expanded_from = out.size();
+    expanding_.push_back(token.lexeme);
+    expand_all_(substituted, out);
+    expanding_.pop_back();
+    return call_from_expansion_(tokens, next, token.lexeme, expanded_from, out);
+}
+
+// A replacement is rescanned together with the rest of the input, so one ending in the name of a
+// function-like macro takes its arguments from the tokens after the call, as with an alias like
+// #define min MIN.  A name from before the expansion already missed its chance, and the macro
+// that was expanded can't call itself this way either.
+std::size_t Preprocessor::call_from_expansion_(std::span<const Token> tokens,
+                                               std::size_t next,
+                                               std::string_view expanded_name,
+                                               std::size_t expanded_from,
+                                               std::vector<Token>& out) {
+    if (out.size() == expanded_from || next >= tokens.size() ||
+        tokens[next].token_type != TokenType::LEFT_PAREN || out.back().token_type != TokenType::IDENTIFIER) {
+        return next;
+    }
+    const auto* found = find_macro_(out.back().lexeme);
+    if (found == nullptr || !found->function_like || out.back().lexeme == expanded_name ||
+        std::find(expanding_.begin(), expanding_.end(), out.back().lexeme) != expanding_.end()) {
+        return next;
+    }
+
+    std::vector<std::vector<Token>> arguments;
+    auto end = collect_arguments_(tokens, next, arguments);
+    std::vector<Token> call{std::move(out.back())};
+    out.pop_back();
+    call.insert(call.end(), tokens.begin() + static_cast<std::ptrdiff_t>(next), tokens.begin() + static_cast<std::ptrdiff_t>(end));
+    expand_all_(call, out);
+    return end;
+}
+
+void Preprocessor::expand_all_(std::span<const Token> tokens, std::vector<Token>& out) {
+    std::size_t idx = 0;
+    while(idx < tokens.size()) {
+        idx = expand_(tokens, idx, out);
+    }
+}
+
+std::size_t Preprocessor::collect_arguments_(std::span<const Token> tokens,
+                                             std::size_t open_paren,
+                                             std::vector<std::vector<Token>>& arguments) {
+    int depth = 0;
+    arguments.emplace_back();
+    for(std::size_t idx = open_paren + 1; idx < tokens.size(); ++idx) {
+        const auto& token = tokens[idx];
+        if (token.token_type == TokenType::DIRECTIVE) {
+            fail(errc::preprocessor_err_macro_arguments, "Directive inside macro arguments", token);
+        }
+        if (token.token_type == TokenType::RIGHT_PAREN && depth == 0) {
+            return idx + 1;
+        }
+        if (token.token_type == TokenType::COMMA && depth == 0) {
+            arguments.emplace_back();
+            continue;
+        }
+        if (token.token_type == TokenType::LEFT_PAREN) {
+            ++depth;
+        } else if (token.token_type == TokenType::RIGHT_PAREN) {
+            --depth;
+        }
+        arguments.back().push_back(token);
+    }
+    fail(errc::preprocessor_err_macro_arguments, "Unterminated macro arguments", tokens[open_paren]);
+}
+
+} // namespace billiec::scanner
@@ -0,0 +1,181 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include <scanner/SourceFileCache.h>
+#include <scanner/ScannerError.h>
+#include <scanner/TokenScanner.h>
+
+#include <core/Hash.h>
+
+#include <fstream>
+#include <iterator>
+
+namespace billiec::scanner {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+std::string_view trim(std::string_view text) {
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::string_view directive_name(const Token& token) {
+    return split_directive(std::get<std::string>(token.token_value)).first;
+}
+
+} // namespace
+
+std::pair<std::string_view, std::string_view> split_directive(std::string_view text) {
+    text = trim(text);
+    std::size_t name_end = 0;
+    while(name_end < text.size() && is_identifier_char(text[name_end])) {
+        ++name_end;
+    }
+    return {text.substr(0, name_end), trim(text.substr(name_end))};
+}
+
+std::string find_include_guard(const std::vector<Token>& tokens) {
+    if (tokens.size() < 2 ||
+        tokens.front().token_type != TokenType::DIRECTIVE ||
+        tokens.back().token_type != TokenType::DIRECTIVE ||
+        directive_name(tokens.front()) != "ifndef" ||
+        directive_name(tokens.back()) != "endif") {
+        return {};
+    }
+
+    // The #ifndef has to stay open until the very last token, with no #else letting code out.
+    int depth = 0;
+    for(std::size_t idx = 0; idx < tokens.size(); ++idx) {
+        if (tokens[idx].token_type != TokenType::DIRECTIVE) {
+            continue;
+        }
+        auto name = directive_name(tokens[idx]);
+        if (name == "if" || name == "ifdef" || name == "ifndef") {
+            ++depth;
+        } else if (name == "endif") {
+            --depth;
+            if (depth == 0 && idx + 1 != tokens.size()) {
+                return {};
+            }
+        } else if ((name == "else" || name == "elif") && depth == 1) {
+            return {};
+        }
+    }
+
+    auto macro = split_directive(std::get<std::string>(tokens.front().token_value)).second;
+    std::size_t name_end = 0;
+    while(name_end < macro.size() && is_identifier_char(macro[name_end])) {
+        ++name_end;
+    }
+    return std::string{macro.substr(0, name_end)};
+}
+
+std::shared_ptr<const SourceFile> SourceFileCache::get(const fs::path& path) {
+    std::error_code ec;
+    auto canonical = fs::weakly_canonical(path, ec);
+    if (ec) {
+        return nullptr;
+    }
+    auto size = fs::file_size(canonical, ec);
+    if (ec) {
+        return nullptr;
+    }
+    auto mtime = fs::last_write_time(canonical, ec);
+    if (ec) {
+        return nullptr;
+    }
+
+    auto key = canonical.string();
+    {
+        std::lock_guard lock{mutex_};
+        auto itr = files_.find(key);
+        if (itr != files_.end() && itr->second.size == size && itr->second.mtime == mtime) {
+            ++hits_;
+            return itr->second.file;
+        }
+        ++misses_;
+    }
+
+    // Read and scan outside the lock, two threads racing on the same new file both just scan it.
+    std::ifstream stream{canonical, std::ios::binary};
+    if (!stream) {
+        return nullptr;
+    }
+    std::string contents{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+
+    auto file = std::make_shared<SourceFile>();
+    file->path = canonical;
+    file->content_hash = hash_bytes(contents);
+    try {
+        file->tokens = TokenScanner{std::move(contents)}.get_tokens();
+    } catch (ScannerError& error) {
+        error.diagnostic.file = canonical.string();
+        throw;
+    }
+    file->include_guard = find_include_guard(file->tokens);
+
+    std::lock_guard lock{mutex_};
+    files_[key] = Entry{file, size, mtime};
+    return file;
+}
+
+std::optional<std::uint64_t> SourceFileCache::content_hash(const fs::path& path) {
+    std::error_code ec;
+    auto canonical = fs::weakly_canonical(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto size = fs::file_size(canonical, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto mtime = fs::last_write_time(canonical, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+
+    auto key = canonical.string();
+    {
+        std::lock_guard lock{mutex_};
+        auto file = files_.find(key);
+        if (file != files_.end() && file->second.size == size && file->second.mtime == mtime) {
+            return file->second.file->content_hash;
+        }
+        auto hash = hashes_.find(key);
+        if (hash != hashes_.end() && hash->second.size == size && hash->second.mtime == mtime) {
+            return hash->second.content_hash;
+        }
+    }
+
+    std::ifstream stream{canonical, std::ios::binary};
+    if (!stream) {
+        return std::nullopt;
+    }
+    std::string contents{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+    auto content_hash = hash_bytes(contents);
+
+    std::lock_guard lock{mutex_};
+    hashes_[key] = HashEntry{content_hash, size, mtime};
+    return content_hash;
+}
+
+std::uint64_t SourceFileCache::hits() const {
+    std::lock_guard lock{mutex_};
+    return hits_;
+}
+
+std::uint64_t SourceFileCache::misses() const {
+    std::lock_guard lock{mutex_};
+    return misses_;
+}
+
+} // namespace billiec::scanner
@@ -4,6 +4,8 @@
 #include <scanner/Errors.h>
 #include <scanner/ScannerError.h>
 
+#include <charconv>
+
 namespace billiec::scanner {
 
 TokenScanner::TokenScanner(std::string inp_source):
@@ -11,15 +13,34 @@ TokenScanner::TokenScanner(std::string inp_source):
     
 }
 
-std::vector<Token> TokenScanner::get_tokens() {
+std::expected<std::vector<Token>, Diagnostics> TokenScanner::scan() {
     while(!is_at_end_()) {
         start_ = current_;
         get_next_token_();
     }
     
+    if (!diagnostics_.empty()) {
+        return std::unexpected{std::move(diagnostics_)};
+    }
     return std::move(tokens_);
 }
 
+std::vector<Token> TokenScanner::get_tokens() {
+    auto tokens = scan();
+    if (!tokens) {
+        const auto& first = tokens.error().front();
+        auto ec = ErrorCode{first.code, first.message};
+        ec << "line: " << first.line;
+        auto diagnostic = Diagnostic{.code = first.code, .message = first.message, .line = first.line};
+        if (first.length > 0) {
+            ec << ", at: " << inp_source_.substr(first.offset, first.length);
+            diagnostic.detail = inp_source_.substr(first.offset, first.length);
+        }
+        throw ScannerError{ec, std::move(diagnostic)};
+    }
+    return std::move(*tokens);
+}
+
 void TokenScanner::get_next_token_() {
     char c = advance_();
     switch(c) {
@@ -42,6 +63,50 @@ void TokenScanner::get_next_token_() {
         case ';':
             add_token_(TokenType::SEMICOLON);
             break;
+            
+        case ',':
+            add_token_(TokenType::COMMA);
+            break;
+            
+        case '!':
+            add_token_(match_('=') ? TokenType::BANG_EQUAL : TokenType::BANG);
+            break;
+            
+        case '=':
+            add_token_(match_('=') ? TokenType::EQUAL_EQUAL : TokenType::EQUAL);
+            break;
+            
+        case '<':
+            add_token_(match_('=') ? TokenType::LESS_EQUAL : TokenType::LESS);
+            break;
+            
+        case '>':
+            add_token_(match_('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER);
+            break;
+            
+        case '&':
+            if (!match_('&')) {
+                error_(errc::scanner_err_invalid_token, "Invalid token");
+                break;
+            }
+            add_token_(TokenType::AMP_AMP);
+            break;
+            
+        case '|':
+            if (!match_('|')) {
+                error_(errc::scanner_err_invalid_token, "Invalid token");
+                break;
+            }
+            add_token_(TokenType::PIPE_PIPE);
+            break;
+            
+        case '#':
+            if (!at_line_start_) {
+                error_(errc::scanner_err_invalid_token, "'#' only starts a preprocessor line");
+                break;
+            }
+            directive_();
+            break;
         
         case '-':
             add_token_(TokenType::MINUS);
@@ -51,24 +116,54 @@ void TokenScanner::get_next_token_() {
             add_token_(TokenType::COMPLEMENT);
             break;
             
+        case '+':
+            add_token_(TokenType::PLUS);
+            break;
+            
+        case '*':
+            add_token_(TokenType::STAR);
+            break;
+            
+        case '/':
+            if (match_('/')) {
+                line_comment_();
+            } else if (match_('*')) {
+                block_comment_();
+            } else {
+                add_token_(TokenType::SLASH);
+            }
+            break;
+            
+        case '%':
+            add_token_(TokenType::PERCENT);
+            break;
+            
         case '\n':
         case '\r':
             ++curr_line_;
+            at_line_start_ = true;
             break;
             
         case '\t':
         case ' ':
             break;
-            
+
+        case '\\':
+            // A backslash before the newline splices the two lines together.
+            if (!match_('\n')) {
+                error_(errc::scanner_err_invalid_token, "Invalid token");
+                break;
+            }
+            ++curr_line_;
+            break;
+
         default:
             if (std::isdigit(c)) {
                 number_();
             } else if (is_alpha_(c)) {
                 identifier_();
             } else {
-                auto ec = ErrorCode{make_error_code(errc::scanner_err_invalid_token), "Invalid token"};
-                ec << "line: " << curr_line_ << ", at character:" << c;
-                throw ScannerError{ec};
+                error_(errc::scanner_err_invalid_token, "Invalid token");
             }
             
             break;
@@ -94,9 +189,13 @@ void TokenScanner::number_() {
         advance_();
     }
     
-    std::string number_string = inp_source_.substr(start_, current_ - start_);
+    int value = 0;
+    auto [end, ec] = std::from_chars(inp_source_.data() + start_, inp_source_.data() + current_, value);
+    if (ec != std::errc{}) {
+        error_(errc::scanner_err_number_out_of_range, "Number doesn't fit in an int");
+    }
     
-    add_token_(TokenType::NUMBER, std::stoi(number_string));
+    add_token_(TokenType::NUMBER, value);
 }
 
 void TokenScanner::string_() {
@@ -129,23 +228,89 @@ void TokenScanner::identifier_() {
 }
 
 
+bool TokenScanner::match_(char expected) {
+    if (peek_() != expected) {
+        return false;
+    }
+    ++current_;
+    return true;
+}
+
+void TokenScanner::directive_() {
+    // A backslash before the newline carries the directive on to the next line.
+    std::string text;
+    while(!is_at_end_() && peek_() != '\n') {
+        char c = advance_();
+        if (c == '\\' && (peek_() == '\n' || (peek_() == '\r' && peek_next_() == '\n'))) {
+            match_('\r');
+            advance_();
+            ++curr_line_;
+            text += ' ';
+        } else if (c != '\r') {
+            text += c;
+        }
+    }
+    
+    add_token_(TokenType::DIRECTIVE, text);
+}
+
+void TokenScanner::line_comment_() {
+    while(!is_at_end_() && peek_() != '\n') {
+        advance_();
+    }
+}
+
+void TokenScanner::block_comment_() {
+    int start_line = curr_line_;
+    while(!is_at_end_() && !(peek_() == '*' && peek_next_() == '/')) {
+        if (advance_() == '\n') {
+            ++curr_line_;
+        }
+    }
+    if (is_at_end_()) {
+        // Only the opening /* is quoted, not the rest of the file.
+        error_(errc::scanner_err_unterminated_comment, "Unterminated comment", start_, 2, start_line);
+        return;
+    }
+    current_ += 2;
+}
+
+// Recorded and scanning goes on, the offending text is whatever this token has taken so far.
+void TokenScanner::error_(errc code, const char* message) {
+    error_(code, message, start_, current_ - start_, curr_line_);
+}
+
+void TokenScanner::error_(errc code, const char* message, int offset, int length, int line) {
+    diagnostics_.report(Diagnostic{
+        .code = make_error_code(code),
+        .message = message,
+        .offset = static_cast<std::uint32_t>(offset),
+        .length = static_cast<std::uint32_t>(length),
+        .line = line
+    });
+}
+
 void TokenScanner::add_token_(TokenType type) {
+    at_line_start_ = false;
     auto lexeme = inp_source_.substr(start_, (current_ - start_));
     tokens_.push_back(Token{
         .token_type = type,
         .token_value = TokenValueType{},
         .lexeme = lexeme,
-        .line = curr_line_
+        .line = curr_line_,
+        .offset = static_cast<std::uint32_t>(start_)
     });
 }
 
 void TokenScanner::add_token_(TokenType type, const TokenValueType& value) {
+    at_line_start_ = false;
     auto lexeme = inp_source_.substr(start_, (current_ - start_));
     tokens_.push_back(Token{
         .token_type = type,
         .token_value = value,
         .lexeme = lexeme,
-        .line = curr_line_
+        .line = curr_line_,
+        .offset = static_cast<std::uint32_t>(start_)
     });
 }
 
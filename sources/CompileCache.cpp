@@ -0,0 +1,267 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include "CompileCache.h"
+#include "RuntimeConfig.h"
+
+#include <core/Hash.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace billiec {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Two differently seeded hashes make a 128-bit key, plenty to treat a match as the same input.
+constexpr std::uint64_t key_seed_low = 0x62696c6c69652d63ull;
+constexpr std::uint64_t key_seed_high = 0x636f6d70696c6572ull;
+
+// Evicting goes a little under the limit so the next few stores don't each trigger a sweep.
+constexpr std::uint64_t evict_to_percent = 90;
+
+/** @brief  Holds an exclusive flock on the cache's lock file while stats and entries change. */
+class CacheLock {
+public:
+    explicit CacheLock(const fs::path& directory) {
+        fd_ = ::open((directory / "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ >= 0) {
+            ::flock(fd_, LOCK_EX);
+        }
+    }
+
+    ~CacheLock() {
+        if (fd_ >= 0) {
+            ::flock(fd_, LOCK_UN);
+            ::close(fd_);
+        }
+    }
+
+    CacheLock(const CacheLock&) = delete;
+    CacheLock& operator=(const CacheLock&) = delete;
+
+private:
+    int fd_{-1};
+};
+
+std::string to_hex(std::uint64_t value) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for(int idx = 15; idx >= 0; --idx) {
+        hex[idx] = digits[value & 0xf];
+        value >>= 4;
+    }
+    return hex;
+}
+
+std::optional<std::string> read_entry(const fs::path& path) {
+    std::ifstream stream{path, std::ios::binary};
+    if (!stream) {
+        return std::nullopt;
+    }
+    std::string contents{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+    if (stream.bad()) {
+        return std::nullopt;
+    }
+    return contents;
+}
+
+} // namespace
+
+CompileCache::CompileCache(std::filesystem::path directory, std::uint64_t max_size):
+    directory{std::move(directory)},
+    max_size{max_size} {
+    std::error_code ec;
+    fs::create_directories(this->directory, ec);
+    enabled_ = !ec && fs::is_directory(this->directory, ec);
+}
+
+std::string CompileCache::compiler_identity() {
+    // A rebuilt compiler can generate different code under the same version, so the binary
+    // itself is part of it too.  Size and mtime are what ccache settles for as well.  Worked out
+    // once, a long running server keeps describing the code it's actually running.
+    static const std::string identity = [] {
+        std::string identity{"billie-c "};
+        identity += compiler_version;
+
+        std::error_code ec;
+        fs::path self{"/proc/self/exe"};
+        auto size = fs::file_size(self, ec);
+        if (!ec) {
+            auto mtime = fs::last_write_time(self, ec);
+            identity += ' ';
+            identity += std::to_string(size);
+            identity += ' ';
+            identity += std::to_string(mtime.time_since_epoch().count());
+        }
+        return identity;
+    }();
+    return identity;
+}
+
+std::string CompileCache::key(std::string_view source, std::string_view options) const {
+    auto low = hash_bytes(options, hash_bytes(source, key_seed_low));
+    auto high = hash_bytes(options, hash_bytes(source, key_seed_high));
+    return to_hex(high) + to_hex(low);
+}
+
+std::optional<std::string> CompileCache::lookup(const std::string& key) {
+    if (!enabled_) {
+        return std::nullopt;
+    }
+
+    auto path = entry_path_(key);
+    auto output = read_entry(path);
+
+    CacheLock lock{directory};
+    auto stats = read_stats_();
+    if (output) {
+        ++stats.hits;
+        // Marks it most recently used for eviction.
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    } else {
+        ++stats.misses;
+    }
+    write_stats_(stats);
+    return output;
+}
+
+void CompileCache::store(const std::string& key, std::string_view output) {
+    if (!enabled_) {
+        return;
+    }
+
+    std::error_code ec;
+    auto path = entry_path_(key);
+    fs::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return;
+    }
+
+    auto temporary = path;
+    // Batch compiles store from several threads of the one process.
+    temporary += ".tmp." + std::to_string(::getpid()) + "." +
+                 std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream stream{temporary, std::ios::binary | std::ios::trunc};
+        stream.write(output.data(), static_cast<std::streamsize>(output.size()));
+        if (!stream.flush()) {
+            stream.close();
+            fs::remove(temporary, ec);
+            return;
+        }
+    }
+
+    CacheLock lock{directory};
+    auto stats = read_stats_();
+    auto replaced_size = fs::file_size(path, ec);
+    if (ec) {
+        replaced_size = 0;
+    }
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return;
+    }
+
+    stats.bytes = stats.bytes - std::min(stats.bytes, replaced_size) + output.size();
+    if (stats.bytes > max_size) {
+        evict_(stats);
+    }
+    write_stats_(stats);
+}
+
+CompileCacheStats CompileCache::stats() const {
+    if (!enabled_) {
+        return {};
+    }
+    CacheLock lock{directory};
+    return read_stats_();
+}
+
+std::filesystem::path CompileCache::entry_path_(const std::string& key) const {
+    // Fanned out by the first two digits so no one directory gets huge.
+    return directory / key.substr(0, 2) / key.substr(2);
+}
+
+CompileCacheStats CompileCache::read_stats_() const {
+    CompileCacheStats stats;
+    std::ifstream stream{directory / "stats"};
+    std::string name;
+    std::uint64_t value = 0;
+    while(stream >> name >> value) {
+        if (name == "hits") {
+            stats.hits = value;
+        } else if (name == "misses") {
+            stats.misses = value;
+        } else if (name == "evictions") {
+            stats.evictions = value;
+        } else if (name == "bytes") {
+            stats.bytes = value;
+        }
+    }
+    return stats;
+}
+
+void CompileCache::write_stats_(const CompileCacheStats& stats) const {
+    std::ofstream stream{directory / "stats", std::ios::trunc};
+    stream << "hits " << stats.hits << "\n"
+           << "misses " << stats.misses << "\n"
+           << "evictions " << stats.evictions << "\n"
+           << "bytes " << stats.bytes << "\n";
+}
+
+void CompileCache::evict_(CompileCacheStats& stats) const {
+    struct Entry {
+        fs::file_time_type last_used;
+        std::uint64_t size{0};
+        fs::path path;
+    };
+
+    // Walk what's really there rather than trusting the counter, that also picks up entries
+    // a crashed compiler stored without counting.
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    std::error_code ec;
+    for(fs::recursive_directory_iterator itr{directory, ec}, end; !ec && itr != end; itr.increment(ec)) {
+        std::error_code entry_ec;
+        if (itr.depth() != 1 || !itr->is_regular_file(entry_ec) ||
+            itr->path().filename().string().find(".tmp.") != std::string::npos) {
+            continue;
+        }
+        Entry entry{itr->last_write_time(entry_ec), itr->file_size(entry_ec), itr->path()};
+        if (!entry_ec) {
+            total += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    std::sort(std::begin(entries), std::end(entries), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.last_used < rhs.last_used;
+    });
+
+    std::uint64_t target = max_size / 100 * evict_to_percent;
+    for(const auto& curr_entry: entries) {
+        if (total <= target) {
+            break;
+        }
+        if (fs::remove(curr_entry.path, ec)) {
+            total -= curr_entry.size;
+            ++stats.evictions;
+        }
+    }
+    stats.bytes = total;
+}
+
+} // namespace billiec
@@ -0,0 +1,55 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace billiec {
+
+/** @brief  Counters the cache keeps in its directory, shared by every compiler using it. */
+struct CompileCacheStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t evictions{0};
+    std::uint64_t bytes{0};         ///< Size of the stored outputs.
+};
+
+/** @brief  Content-addressed on-disk cache of compiler output.
+ *
+ * Entries are keyed by a hash of the source bytes and of everything else the output depends on,
+ * so a hit can hand back the stored output without running any phase.  Entries are written to a
+ * temporary and renamed into place so concurrent compilers never see half an entry, a hit bumps
+ * the entry's modification time, and once the stored outputs outgrow \c max_size the least
+ * recently used ones go.  Any I/O trouble just turns into a miss, the cache never fails a compile.
+ */
+struct CompileCache {
+    static constexpr std::uint64_t default_max_size = 256ull * 1024 * 1024;
+
+    std::filesystem::path directory;
+    std::uint64_t max_size{default_max_size};
+
+    CompileCache(std::filesystem::path directory, std::uint64_t max_size = default_max_size);
+
+    /** @brief  What identifies the running compiler binary, its version plus size and mtime. */
+    static std::string compiler_identity();
+
+    /** @brief  The key for a source, \c options is everything besides the source the output depends on. */
+    std::string key(std::string_view source, std::string_view options) const;
+
+    std::optional<std::string> lookup(const std::string& key);
+    void store(const std::string& key, std::string_view output);
+    CompileCacheStats stats() const;
+
+private:
+    bool enabled_{false};
+
+    std::filesystem::path entry_path_(const std::string& key) const;
+    CompileCacheStats read_stats_() const;
+    void write_stats_(const CompileCacheStats& stats) const;
+    void evict_(CompileCacheStats& stats) const;
+};
+
+} // namespace billiec
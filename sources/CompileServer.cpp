@@ -0,0 +1,289 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include "CompileServer.h"
+#include "Errors.h"
+#include "RuntimeError.h"
+
+#include <core/WorkStealingPool.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace billiec {
+
+namespace {
+
+// On the wire, a request is the argument count, the working directory and arguments, then a
+// flag byte and the source if one was sent.  The reply is the exit status and the stdout text.
+// Strings are a 32-bit length followed by the bytes, both ends are on the same machine so
+// integers go in host order.
+
+// Far more than any real command line or source, a request past them is dropped before
+// anything is allocated for it.
+constexpr std::uint32_t max_request_arguments = 4096;
+constexpr std::uint32_t max_request_string_size = 64u << 20;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+extern "C" void request_stop(int) {
+    stop_requested = 1;
+}
+
+[[noreturn]] void throw_socket_error(errc code, const std::string& what, const std::string& socket_path) {
+    ErrorCode ec{make_error_code(code), what};
+    ec << socket_path << ": " << std::strerror(errno);
+    throw RuntimeError(std::move(ec));
+}
+
+sockaddr_un socket_address(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        throw_socket_error(errc::server_socket_failed, "Socket path too long: ", socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return address;
+}
+
+bool write_all(int fd, const void* data, std::size_t size) {
+    auto bytes = static_cast<const char*>(data);
+    while(size != 0) {
+        auto written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, std::size_t size) {
+    auto bytes = static_cast<char*>(data);
+    while(size != 0) {
+        auto received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+bool write_u32(int fd, std::uint32_t value) {
+    return write_all(fd, &value, sizeof(value));
+}
+
+bool read_u32(int fd, std::uint32_t& value) {
+    return read_all(fd, &value, sizeof(value));
+}
+
+bool write_string(int fd, const std::string& text) {
+    return write_u32(fd, static_cast<std::uint32_t>(text.size())) && write_all(fd, text.data(), text.size());
+}
+
+bool read_string(int fd, std::string& text, std::uint32_t max_size = UINT32_MAX) {
+    std::uint32_t size = 0;
+    if (!read_u32(fd, size) || size > max_size) {
+        return false;
+    }
+    text.resize(size);
+    return read_all(fd, text.data(), size);
+}
+
+bool write_request(int fd, const CompileRequest& request) {
+    if (!write_u32(fd, static_cast<std::uint32_t>(request.arguments.size())) ||
+        !write_string(fd, request.working_directory)) {
+        return false;
+    }
+    for(const auto& curr_argument: request.arguments) {
+        if (!write_string(fd, curr_argument)) {
+            return false;
+        }
+    }
+    char has_source = request.source.has_value() ? 1 : 0;
+    return write_all(fd, &has_source, 1) && (!has_source || write_string(fd, *request.source));
+}
+
+bool read_request(int fd, CompileRequest& request) {
+    std::uint32_t argument_count = 0;
+    if (!read_u32(fd, argument_count) || argument_count > max_request_arguments ||
+        !read_string(fd, request.working_directory, max_request_string_size)) {
+        return false;
+    }
+    request.arguments.resize(argument_count);
+    for(auto& curr_argument: request.arguments) {
+        if (!read_string(fd, curr_argument, max_request_string_size)) {
+            return false;
+        }
+    }
+    char has_source = 0;
+    if (!read_all(fd, &has_source, 1)) {
+        return false;
+    }
+    if (has_source) {
+        request.source.emplace();
+        return read_string(fd, *request.source, max_request_string_size);
+    }
+    return true;
+}
+
+/** @brief  Closes the descriptor when it goes out of scope. */
+class SocketHandle {
+public:
+    explicit SocketHandle(int fd):
+        fd_{fd} {
+    }
+
+    ~SocketHandle() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    SocketHandle(const SocketHandle&) = delete;
+    SocketHandle& operator=(const SocketHandle&) = delete;
+
+    int get() const {
+        return fd_;
+    }
+
+private:
+    int fd_;
+};
+
+} // namespace
+
+CompileServer::CompileServer(std::string socket_path, CompileRequestHandler handler, std::size_t jobs):
+    socket_path_{std::move(socket_path)},
+    handler_{std::move(handler)},
+    jobs_{jobs} {
+}
+
+void CompileServer::run() {
+    auto address = socket_address(socket_path_);
+
+    // Non-blocking so a client that hangs up between ppoll and accept can't stall the loop.
+    SocketHandle listener{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0)};
+    if (listener.get() < 0) {
+        throw_socket_error(errc::server_socket_failed, "Can't create socket ", socket_path_);
+    }
+
+    // A socket file nobody answers on is left over from a server that died, take it over.
+    {
+        SocketHandle probe{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+        if (::connect(probe.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+            errno = EADDRINUSE;
+            throw_socket_error(errc::server_socket_failed, "A server is already listening on ", socket_path_);
+        }
+        if (errno == ECONNREFUSED) {
+            ::unlink(socket_path_.c_str());
+        }
+    }
+
+    if (::bind(listener.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener.get(), SOMAXCONN) != 0) {
+        throw_socket_error(errc::server_socket_failed, "Can't listen on ", socket_path_);
+    }
+
+    // The stop signals stay blocked everywhere but inside ppoll, so the workers never see them
+    // and one arriving between the check of stop_requested and the wait is held until the wait.
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    sigset_t waiting_mask;
+    ::pthread_sigmask(SIG_BLOCK, &stop_signals, &waiting_mask);
+    sigdelset(&waiting_mask, SIGINT);
+    sigdelset(&waiting_mask, SIGTERM);
+
+    struct sigaction action{};
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    {
+        WorkStealingPool pool{jobs_};
+
+        pollfd waiting{.fd = listener.get(), .events = POLLIN, .revents = 0};
+        while(!stop_requested) {
+            if (::ppoll(&waiting, 1, nullptr, &waiting_mask) <= 0) {
+                continue;
+            }
+            int connection = ::accept4(listener.get(), nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection < 0) {
+                continue;
+            }
+            pool.submit([this, connection] { serve_connection_(connection); });
+        }
+    }
+
+    ::unlink(socket_path_.c_str());
+    ::pthread_sigmask(SIG_UNBLOCK, &stop_signals, nullptr);
+}
+
+// Runs on the pool, which can't take exceptions: anything that escapes the handler, running out
+// of memory reading the request included, just drops this one connection.
+void CompileServer::serve_connection_(int connection) const {
+    SocketHandle handle{connection};
+    try {
+        CompileRequest request;
+        if (!read_request(handle.get(), request)) {
+            return;
+        }
+
+        std::ostringstream out;
+        int status = 0;
+        try {
+            status = handler_(request, out);
+        } catch (const std::exception& exc) {
+            out << "Caught: " << exc.what() << "\n";
+            status = 44;
+        }
+
+        if (write_u32(handle.get(), static_cast<std::uint32_t>(status))) {
+            write_string(handle.get(), std::move(out).str());
+        }
+    } catch (const std::exception&) {
+    }
+}
+
+int forward_to_server(const std::string& socket_path, const CompileRequest& request, std::ostream& out) {
+    auto address = socket_address(socket_path);
+
+    SocketHandle connection{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (connection.get() < 0 ||
+        ::connect(connection.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        throw_socket_error(errc::server_unreachable, "No compile server on ", socket_path);
+    }
+
+    std::uint32_t status = 0;
+    std::string text;
+    if (!write_request(connection.get(), request) ||
+        !read_u32(connection.get(), status) ||
+        !read_string(connection.get(), text)) {
+        throw_socket_error(errc::server_unreachable, "Compile server hung up: ", socket_path);
+    }
+
+    out << text;
+    return static_cast<int>(status);
+}
+
+} // namespace billiec
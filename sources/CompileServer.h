@@ -0,0 +1,46 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace billiec {
+
+/** @brief  One forwarded compile, a command line as the client was given it. */
+struct CompileRequest {
+    std::string working_directory;          ///< Relative paths in \c arguments are relative to this.
+    std::vector<std::string> arguments;     ///< Without the program name.
+    std::optional<std::string> source;      ///< Source sent along instead of read from the input file.
+};
+
+/** @brief  Compiles a request writing what would go to stdout into \c out, returns the exit status. */
+using CompileRequestHandler = std::function<int(const CompileRequest& request, std::ostream& out)>;
+
+/** @brief  Keeps one warm compiler process answering compile requests on a Unix domain socket.
+ *
+ * Each connection carries one request and gets back the exit status and the stdout text.
+ * Connections are handed to a work-stealing pool so requests run side by side.  \c run returns
+ * once SIGINT or SIGTERM arrives, the socket file is removed on the way out.
+ */
+class CompileServer {
+public:
+    CompileServer(std::string socket_path, CompileRequestHandler handler, std::size_t jobs = 0);
+
+    void run();
+
+private:
+    std::string socket_path_;
+    CompileRequestHandler handler_;
+    std::size_t jobs_;
+
+    void serve_connection_(int connection) const;
+};
+
+/** @brief  Sends a request to the server listening on \c socket_path, returns the exit status it sent back. */
+int forward_to_server(const std::string& socket_path, const CompileRequest& request, std::ostream& out);
+
+} // namespace billiec
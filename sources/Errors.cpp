@@ -27,6 +27,32 @@ struct ErrorCategory: public std::error_category
                 return "output_file_missing";
             case errc::unknown_cmdline_option:
                 return "unknown_cmdline_option";
+            case errc::unknown_mcpu:
+                return "unknown_mcpu";
+            case errc::invalid_cache_size:
+                return "invalid_cache_size";
+            case errc::batch_with_output:
+                return "batch_with_output";
+            case errc::response_file_unreadable:
+                return "response_file_unreadable";
+            case errc::server_socket_failed:
+                return "server_socket_failed";
+            case errc::server_unreachable:
+                return "server_unreachable";
+            case errc::unsupported_server_request:
+                return "unsupported_server_request";
+            case errc::allocation_tracking_disabled:
+                return "allocation_tracking_disabled";
+            case errc::allocation_budget_exceeded:
+                return "allocation_budget_exceeded";
+            case errc::precompiled_header_unusable:
+                return "precompiled_header_unusable";
+            case errc::precompiled_header_write_failed:
+                return "precompiled_header_write_failed";
+            case errc::compile_errors:
+                return "compile_errors";
+            case errc::unknown_optimization_level:
+                return "unknown_optimization_level";
             default:
                 return "Unknown Error";
         }
@@ -8,7 +8,20 @@ enum class errc {
     no_error = 0x00,
     file_not_specified,
     output_file_missing,
-    unknown_cmdline_option
+    unknown_cmdline_option,
+    unknown_mcpu,
+    invalid_cache_size,
+    batch_with_output,
+    response_file_unreadable,
+    server_socket_failed,
+    server_unreachable,
+    unsupported_server_request,
+    allocation_tracking_disabled,
+    allocation_budget_exceeded,
+    precompiled_header_unusable,
+    precompiled_header_write_failed,
+    compile_errors,
+    unknown_optimization_level
 };
 
 std::error_code make_error_code(errc err);
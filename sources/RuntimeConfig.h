@@ -1,10 +1,19 @@
 // Copyright 2025, Yasser Zabuair.
 #pragma once
 
+#include "CompileCache.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace billiec {
 
+inline constexpr std::string_view compiler_version{"0.1.0"};
+
 enum class RunStage {
     stage_lexer,
     stage_parser,
@@ -12,10 +21,39 @@ enum class RunStage {
     stage_all
 };
 
+enum class TimeReportFormat {
+    none,
+    text,
+    json
+};
+
 struct RuntimeConfig {
     RunStage    run_stage = RunStage::stage_all;
+    bool        show_help{false};               ///< --help was given, nothing else runs.
     std::string input_file;
     std::string output_file;
+    bool        print_value_numbering_stats{false};
+    bool        print_regalloc_stats{false};
+    bool        print_peephole_stats{false};
+    bool        print_schedule_stats{false};
+    std::string mcpu{"generic"};
+    std::string optimization_level{"1"};        ///< The name after -O.
+    std::vector<std::string> include_directories;  ///< Searched by #include in the order given.
+    std::vector<std::pair<std::string, std::string>> defines;   ///< Macro names and bodies from -D.
+    std::string emit_pch;                       ///< Precompile the input header to this file instead of compiling.
+    std::string include_pch;                    ///< Precompiled header to start every compile from.
+    TimeReportFormat time_report{TimeReportFormat::none};
+    std::string trace_file;                     ///< Chrome trace-event JSON written here at exit.
+    bool        check_allocation_budgets{false};    ///< Fail compiles whose phases allocate past their budget.
+    bool        deterministic_output{false};    ///< Leave the timestamp out of the assembly.
+    std::string cache_dir;                      ///< Compile cache to use, none when empty.
+    std::uint64_t cache_max_size{CompileCache::default_max_size};
+    bool        print_cache_stats{false};
+    bool        batch_mode{false};              ///< Compile every file in \c input_files, each next to its input.
+    std::vector<std::string> input_files;       ///< Every input named, \c input_file is the last of them.
+    std::size_t jobs{0};                        ///< Batch and server worker threads, zero for one per hardware thread.
+    std::string serve_socket;                   ///< Run as a compile server listening here.
+    std::string connect_socket;                 ///< Hand the compile to the server listening here.
 };
 
 } // namespace billiec
@@ -0,0 +1,138 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#include "TimeReport.h"
+
+#include <core/Json.h>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iomanip>
+
+namespace billiec {
+
+namespace {
+
+std::int64_t clock_ns(clockid_t clock) {
+    timespec now{};
+    ::clock_gettime(clock, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+std::uint64_t peak_rss_kb() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+}
+
+// Without allocation tracking built in the counts are left out rather than shown as zero.
+void write_json_phase(std::ostream& out, const PhaseTiming& phase) {
+    out << "{\"name\":";
+    write_json_string(out, phase.name);
+    out << ",\"wall_ms\":" << phase.wall_ms
+        << ",\"cpu_ms\":" << phase.cpu_ms;
+    if constexpr (allocation_tracking_enabled) {
+        out << ",\"allocations\":" << phase.allocations
+            << ",\"bytes\":" << phase.bytes;
+    }
+    out << ",\"peak_rss_kb\":" << phase.peak_rss_kb << '}';
+}
+
+void write_text_phase(std::ostream& out, const PhaseTiming& phase) {
+    out << std::left << std::setw(20) << phase.name << std::right
+        << std::setw(12) << phase.wall_ms
+        << std::setw(12) << phase.cpu_ms;
+    if constexpr (allocation_tracking_enabled) {
+        out << std::setw(12) << phase.allocations
+            << std::setw(14) << phase.bytes;
+    } else {
+        out << std::setw(12) << "-"
+            << std::setw(14) << "-";
+    }
+    out << std::setw(14) << phase.peak_rss_kb << "\n";
+}
+
+} // namespace
+
+TimeReport::Sample TimeReport::sample_() {
+    return {clock_ns(CLOCK_MONOTONIC), clock_ns(CLOCK_THREAD_CPUTIME_ID)};
+}
+
+void TimeReport::record_(const char* name, const Sample& start, const AllocationCounts& allocations) {
+    auto end = sample_();
+    PhaseTiming phase;
+    phase.name = name;
+    phase.wall_ms = static_cast<double>(end.wall_ns - start.wall_ns) / 1e6;
+    phase.cpu_ms = static_cast<double>(end.cpu_ns - start.cpu_ns) / 1e6;
+    phase.allocations = allocations.allocations;
+    phase.bytes = allocations.bytes;
+    phase.peak_rss_kb = peak_rss_kb();
+    phases_.push_back(std::move(phase));
+}
+
+const PhaseTiming* TimeReport::find(std::string_view name) const {
+    for(const auto& curr_phase: phases_) {
+        if (curr_phase.name == name) {
+            return &curr_phase;
+        }
+    }
+    return nullptr;
+}
+
+PhaseTiming TimeReport::total_() const {
+    PhaseTiming total;
+    total.name = "total";
+    for(const auto& curr_phase: phases_) {
+        total.wall_ms += curr_phase.wall_ms;
+        total.cpu_ms += curr_phase.cpu_ms;
+        total.allocations += curr_phase.allocations;
+        total.bytes += curr_phase.bytes;
+        total.peak_rss_kb = std::max(total.peak_rss_kb, curr_phase.peak_rss_kb);
+    }
+    return total;
+}
+
+void TimeReport::print_text(std::ostream& out, const std::string& input_file) const {
+    auto flags = out.flags();
+    auto precision = out.precision();
+
+    out << "time report " << input_file << "\n";
+    out << std::left << std::setw(20) << "phase" << std::right
+        << std::setw(12) << "wall ms"
+        << std::setw(12) << "cpu ms"
+        << std::setw(12) << "allocs"
+        << std::setw(14) << "bytes"
+        << std::setw(14) << "peak rss kb" << "\n";
+    out << std::fixed << std::setprecision(3);
+    for(const auto& curr_phase: phases_) {
+        write_text_phase(out, curr_phase);
+    }
+    write_text_phase(out, total_());
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void TimeReport::print_json(std::ostream& out, const std::string& input_file) const {
+    auto flags = out.flags();
+    auto precision = out.precision();
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"file\":";
+    write_json_string(out, input_file);
+    out << ",\"phases\":[";
+    for(std::size_t idx = 0; idx < phases_.size(); ++idx) {
+        if (idx != 0) {
+            out << ',';
+        }
+        write_json_phase(out, phases_[idx]);
+    }
+    out << "],\"total\":";
+    write_json_phase(out, total_());
+    out << "}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace billiec
@@ -0,0 +1,89 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+#pragma once
+
+#include <core/AllocationTracker.h>
+#include <core/Trace.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace billiec {
+
+/** @brief  What one phase of a compile cost. */
+struct PhaseTiming {
+    std::string name;
+    double wall_ms{0.0};
+    double cpu_ms{0.0};             ///< This thread's CPU time, so batch compiles don't count each other.
+    std::uint64_t allocations{0};   ///< Zero unless built with allocation tracking.
+    std::uint64_t bytes{0};         ///< Allocated during the phase, frees aren't subtracted.
+    std::uint64_t peak_rss_kb{0};   ///< The process's high water mark once the phase is done.
+};
+
+/** @brief  Collects wall time, CPU time, allocations and peak RSS phase by phase.
+ *
+ * Each phase runs under an AllocationScope tagged with its name.  A disabled report runs the
+ * phases without measuring anything.
+ */
+class TimeReport {
+public:
+    explicit TimeReport(bool enabled):
+        enabled_{enabled} {
+    }
+
+    /** @brief  Runs \c fn as the phase \c name, returns whatever \c fn returns.  The phase is traced either way. */
+    template <typename Fn>
+    decltype(auto) measure(const char* name, Fn&& fn) {
+        TraceSpan span{"phase", name};
+        if (!enabled_) {
+            return std::forward<Fn>(fn)();
+        }
+
+        AllocationScope scope{name};
+        auto start = sample_();
+        if constexpr (std::is_void_v<std::invoke_result_t<Fn>>) {
+            std::forward<Fn>(fn)();
+            record_(name, start, scope.counts());
+        } else {
+            decltype(auto) result = std::forward<Fn>(fn)();
+            record_(name, start, scope.counts());
+            return result;
+        }
+    }
+
+    bool enabled() const {
+        return enabled_;
+    }
+
+    const std::vector<PhaseTiming>& phases() const {
+        return phases_;
+    }
+
+    /** @brief  The phase called \c name, null if it didn't run. */
+    const PhaseTiming* find(std::string_view name) const;
+
+    /** @brief  One row per phase and a total, lined up for reading. */
+    void print_text(std::ostream& out, const std::string& input_file) const;
+
+    /** @brief  The whole report as one line of JSON, so many compiles append into a JSON Lines log. */
+    void print_json(std::ostream& out, const std::string& input_file) const;
+
+private:
+    struct Sample {
+        std::int64_t wall_ns{0};
+        std::int64_t cpu_ns{0};
+    };
+
+    bool enabled_;
+    std::vector<PhaseTiming> phases_;
+
+    static Sample sample_();
+    void record_(const char* name, const Sample& start, const AllocationCounts& allocations);
+    PhaseTiming total_() const;
+};
+
+} // namespace billiec
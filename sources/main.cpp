@@ -1,24 +1,44 @@
 // Copyright 2025, Yasser Zabuair.  See LICENSE for detials.
 
+#include "CompileCache.h"
+#include "CompileServer.h"
 #include "Errors.h"
 #include "RuntimeConfig.h"
 #include "RuntimeError.h"
+#include "TimeReport.h"
 
-#include <codegen/AssemblyGenerator.h>
+#include <billie/Pipeline.h>
 #include <codegen/AssemblerPassEmit.h>
-#include <codegen/AssemblerPassFixInstructions.h>
-#include <codegen/AssemblerPassPseudoRegister.h>
 #include <codegen/AstPrinter.h>
-#include <codegen/TackyGenerator.h>
+#include <codegen/MachineModel.h>
+#include <codegen/OptimizationLevel.h>
+#include <core/Diagnostics.h>
 #include <core/ErrorHelpers.h>
+#include <core/Trace.h>
+#include <core/WorkStealingPool.h>
+#include <scanner/PrecompiledHeader.h>
+#include <scanner/Preprocessor.h>
+#include <scanner/SourceFileCache.h>
 #include <scanner/TokenScanner.h>
 #include <parser/LanguageParser.h>
 
+#include <charconv>
+#include <cstdlib>
 #include <cstring>
 #include <expected>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 void print_banner() {
     std::cout << "Copyright 2025 Yasser Zabuair.  See LICENSE for details.\n";
@@ -27,10 +47,37 @@ void print_banner() {
 
 void print_help() {
     std::cout << "billie <options> file_name\n";
+    std::cout << "billie --batch <options> file_name... @response_file...\n";
     std::cout << "--help   This screen\n";
     std::cout << "--lex  Run lexer phase.\n";
     std::cout << "--parse  Run parse phase.\n";
     std::cout << "--codegen  Run codegen phase.\n";
+    std::cout << "--regalloc-stats  Print register allocation numbers per function.\n";
+    std::cout << "--value-numbering-stats  Print how many redundant and constant instructions value numbering removed.\n";
+    std::cout << "--peephole-stats  Print how often each peephole rule fired.\n";
+    std::cout << "--schedule-stats  Print estimated cycles per function before and after scheduling.\n";
+    std::cout << "-mcpu=<name>  Schedule for generic, neoverse-n1 or apple-m1.\n";
+    std::cout << "-O<level>  0 leaves out value numbering, peephole and scheduling, 1 runs them (the default).\n";
+    std::cout << "-I<dir>  Look for #include files in dir too.\n";
+    std::cout << "-D<name>[=<value>]  Define name as value, 1 when no value is given.\n";
+    std::cout << "--emit-pch=<file>  Precompile the header given as the input into file.\n";
+    std::cout << "--include-pch=<file>  Start from a precompiled header, as if its header was included first.\n";
+    std::cout << "                      Its header is preprocessed instead when a file it read has changed.\n";
+    std::cout << "--time-report  Print wall and CPU time, allocations and peak RSS for each phase.\n";
+    std::cout << "--time-report=json  The same as one line of JSON per compile.\n";
+    std::cout << "--trace=<file>  Write a Chrome/Perfetto trace of every phase, pass and function to file.\n";
+    std::cout << "--check-allocation-budgets  Fail when a phase allocates more than its budget.\n";
+    std::cout << "                            Needs a build configured with -DBILLIE_TRACK_ALLOCATIONS=ON.\n";
+    std::cout << "--deterministic  Leave the timestamp out so the same input gives the same output.\n";
+    std::cout << "--cache-dir=<dir>  Reuse output from earlier compiles stored in dir, implies --deterministic.\n";
+    std::cout << "                   Skipped when any of the pass stats are asked for.\n";
+    std::cout << "--cache-max-size=<size>  Evict least recently used outputs past size bytes, k/m/g suffixes work.\n";
+    std::cout << "--cache-stats  Print the cache's hit, miss and eviction counts.\n";
+    std::cout << "--batch  Compile every file given on all cores, each to a .s next to it.\n";
+    std::cout << "         @file reads more file names from file, one per line.\n";
+    std::cout << "--jobs=<n>  Batch and server worker threads, one per hardware thread by default.\n";
+    std::cout << "--serve=<socket>  Stay up answering compile requests on a Unix socket.\n";
+    std::cout << "--connect=<socket>  Have the server on socket do this compile, - as the file sends stdin.\n";
 }
 
 std::string read_file(const std::string filename) {
@@ -44,84 +91,550 @@ std::string read_file(const std::string filename) {
     return source_file;
 }
 
+// Prints every diagnostic to out, then fails the compile with how many there were.
+[[noreturn]] void fail_compile(const billiec::RuntimeConfig& cfg, const billiec::Diagnostics& diagnostics,
+                               std::string_view file_source, std::ostream& out) {
+    diagnostics.print(out, file_source, cfg.input_file);
+    billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::compile_errors), "Errors: "};
+    ec << diagnostics.size();
+    throw billiec::RuntimeError(std::move(ec));
+}
+
+// Every bad token is reported, but a source that doesn't scan isn't parsed.
+std::vector<billiec::scanner::Token> scan_source(const billiec::RuntimeConfig& cfg, const std::string& file_source,
+                                                 std::ostream& out) {
+    billiec::scanner::TokenScanner scanner{file_source};
+    auto tokens = scanner.scan();
+    if (!tokens) {
+        fail_compile(cfg, tokens.error(), file_source, out);
+    }
+    return std::move(*tokens);
+}
+
+billiec::parser::ProgramNode::PtrType parse_tokens(const billiec::RuntimeConfig& cfg,
+                                                   std::vector<billiec::scanner::Token> tokens,
+                                                   std::string_view file_source, std::ostream& out) {
+    billiec::parser::LanguageParser parser{std::move(tokens)};
+    auto program_node = parser.parse();
+    if (!program_node) {
+        fail_compile(cfg, program_node.error(), file_source, out);
+    }
+    return std::move(*program_node);
+}
+
 void run_lexer(const billiec::RuntimeConfig& cfg) {
     auto file_source = read_file(cfg.input_file);
-    billiec::scanner::TokenScanner scanner{file_source};
-    
-    auto tokens = scanner.get_tokens();
+    auto tokens = scan_source(cfg, file_source, std::cout);
     
     for(const auto& curr_token: tokens) {
         std::cout << curr_token;
     }
 }
 
+// Shared by every compile in the process, so a header a whole batch includes is read and scanned once.
+billiec::scanner::SourceFileCache& source_file_cache() {
+    static billiec::scanner::SourceFileCache cache;
+    return cache;
+}
+
+// Sources without a single '#' and no -D have nothing for the preprocessor to do.
+bool needs_preprocessing(const billiec::RuntimeConfig& cfg, const std::string& file_source) {
+    return !cfg.defines.empty() || !cfg.include_pch.empty() || file_source.find('#') != std::string::npos;
+}
+
+// A precompiled header is only good for the same compiler with the same -I and -D.
+std::string precompiled_header_identity(const billiec::RuntimeConfig& cfg) {
+    auto identity = billiec::CompileCache::compiler_identity();
+    for(const auto& curr_directory: cfg.include_directories) {
+        identity += "\n-I" + std::filesystem::absolute(curr_directory).string();
+    }
+    for(const auto& [name, body]: cfg.defines) {
+        identity += "\n-D" + name + "=" + body;
+    }
+    return identity;
+}
+
+/** @brief  Maps each precompiled header once per process, batch and server compiles all share it.
+ *
+ * A header rebuilt since it was mapped has a new size or modification time and gets mapped again.
+ */
+std::shared_ptr<const billiec::scanner::PrecompiledHeader> load_precompiled_header(const billiec::RuntimeConfig& cfg) {
+    struct Loaded {
+        std::shared_ptr<const billiec::scanner::PrecompiledHeader> precompiled_header;
+        std::uintmax_t size{0};
+        std::filesystem::file_time_type mtime;
+    };
+    static std::mutex loaded_mutex;
+    static std::unordered_map<std::string, Loaded> loaded;
+    
+    auto identity = precompiled_header_identity(cfg);
+    auto key = std::filesystem::absolute(cfg.include_pch).string() + "\n" + identity;
+    std::error_code ec;
+    auto size = std::filesystem::file_size(cfg.include_pch, ec);
+    auto mtime = std::filesystem::last_write_time(cfg.include_pch, ec);
+    
+    std::lock_guard lock{loaded_mutex};
+    auto itr = loaded.find(key);
+    if (itr == loaded.end() || itr->second.size != size || itr->second.mtime != mtime) {
+        auto precompiled_header = billiec::scanner::PrecompiledHeader::open(cfg.include_pch, identity);
+        if (!precompiled_header) {
+            billiec::ErrorCode error{billiec::make_error_code(billiec::errc::precompiled_header_unusable),
+                                     "Can't use the precompiled header, rebuild it with --emit-pch using the same -I and -D: "};
+            error << cfg.include_pch;
+            throw billiec::RuntimeError(std::move(error));
+        }
+        itr = loaded.insert_or_assign(key, Loaded{std::move(precompiled_header), size, mtime}).first;
+    }
+    return itr->second.precompiled_header;
+}
+
+billiec::scanner::Preprocessor make_preprocessor(const billiec::RuntimeConfig& cfg) {
+    std::vector<std::filesystem::path> include_directories{cfg.include_directories.begin(),
+                                                           cfg.include_directories.end()};
+    billiec::scanner::Preprocessor preprocessor{source_file_cache(), std::move(include_directories)};
+    for(const auto& [name, body]: cfg.defines) {
+        preprocessor.define(name, body);
+    }
+    return preprocessor;
+}
+
+std::vector<billiec::scanner::Token> preprocess(const billiec::RuntimeConfig& cfg,
+                                                const std::vector<billiec::scanner::Token>& tokens) {
+    auto preprocessor = make_preprocessor(cfg);
+    if (!cfg.include_pch.empty()) {
+        // A stale precompiled header still names its header, preprocessing that gives the same tokens.
+        auto precompiled_header = load_precompiled_header(cfg);
+        if (precompiled_header->is_current(source_file_cache())) {
+            preprocessor.use_precompiled_header(std::move(precompiled_header));
+        } else {
+            preprocessor.include(precompiled_header->header());
+        }
+    }
+    return preprocessor.preprocess(tokens, std::filesystem::absolute(cfg.input_file));
+}
+
+void run_emit_pch(const billiec::RuntimeConfig& cfg) {
+    if (!cfg.include_pch.empty()) {
+        throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::precompiled_header_unusable),
+                                    "Precompiled headers don't chain, --emit-pch can't be used with --include-pch."}};
+    }
+    auto header = std::filesystem::absolute(cfg.input_file);
+    auto preprocessor = make_preprocessor(cfg);
+    preprocessor.include(header);
+    auto tokens = preprocessor.preprocess({}, header);
+    
+    auto contents = preprocessor.precompiled_header(header, std::move(tokens));
+    if (!billiec::scanner::PrecompiledHeader::write(cfg.emit_pch, contents, precompiled_header_identity(cfg))) {
+        billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::precompiled_header_write_failed),
+                              "Can't write the precompiled header: "};
+        ec << cfg.emit_pch;
+        throw billiec::RuntimeError(std::move(ec));
+    }
+}
+
 void run_parser(const billiec::RuntimeConfig& cfg) {
     auto file_source = read_file(cfg.input_file);
     
-    billiec::scanner::TokenScanner scanner{file_source};
-    auto tokens = scanner.get_tokens();
+    auto tokens = scan_source(cfg, file_source, std::cout);
+    if (needs_preprocessing(cfg, file_source)) {
+        tokens = preprocess(cfg, tokens);
+    }
     
-    billiec::parser::LanguageParser parser{tokens};
-    auto program_node = parser.parse_program();
+    auto program_node = parse_tokens(cfg, std::move(tokens), file_source, std::cout);
     billiec::codegen::AstPrinter ast_printer{std::move(program_node)};
     ast_printer.print_ast();
 }
 
-void run_codegen(const billiec::RuntimeConfig& cfg) {
-    auto file_source = read_file(cfg.input_file);
+void write_output(const billiec::RuntimeConfig& cfg, std::ostream& out, std::string_view assembly) {
+    if (!cfg.output_file.empty()) {
+        std::ofstream stream{cfg.output_file};
+        stream.write(assembly.data(), static_cast<std::streamsize>(assembly.size()));
+    } else {
+        out.write(assembly.data(), static_cast<std::streamsize>(assembly.size()));
+    }
+}
+
+bool wants_pass_stats(const billiec::RuntimeConfig& cfg) {
+    return cfg.print_value_numbering_stats || cfg.print_regalloc_stats || cfg.print_peephole_stats ||
+           cfg.print_schedule_stats;
+}
+
+// Everything besides the source that changes what codegen produces.
+std::string cache_options(const billiec::RuntimeConfig& cfg) {
+    return billiec::CompileCache::compiler_identity() + "\n--codegen\n-mcpu=" + cfg.mcpu + "\n-O" + cfg.optimization_level;
+}
+
+void print_cache_stats(const billiec::RuntimeConfig& cfg) {
+    billiec::CompileCache cache{cfg.cache_dir, cfg.cache_max_size};
+    auto stats = cache.stats();
+    std::cout << "cache " << cfg.cache_dir
+              << ": hits=" << stats.hits
+              << " misses=" << stats.misses
+              << " evictions=" << stats.evictions
+              << " bytes=" << stats.bytes << "\n";
+}
+
+enum class BudgetUnit {
+    none,
+    token,
+    instruction
+};
+
+/** @brief  How much a phase may allocate, \c max_per_unit for each token or instruction plus \c allowance. */
+struct AllocationBudget {
+    const char* phase;
+    BudgetUnit unit;
+    double max_per_unit;
+    std::uint64_t allowance;
+};
+
+// The hot paths that are meant to stay close to allocation free, the allowance covers buffers
+// and tables growing.  Phases not listed are free to allocate per node for now.
+constexpr AllocationBudget allocation_budgets[] = {
+    {"lex",                 BudgetUnit::token,       1.0 / 16, 64},
+    {"register allocation", BudgetUnit::instruction, 1.0 / 64, 128},
+    {"fix instructions",    BudgetUnit::none,        0.0,      16},
+    {"peephole",            BudgetUnit::none,        0.0,      32},
+    {"emit",                BudgetUnit::none,        0.0,      48},
+};
+
+void check_allocation_budgets(const billiec::TimeReport& report, std::uint64_t tokens, std::uint64_t instructions) {
+    std::ostringstream exceeded;
+    for(const auto& curr_budget: allocation_budgets) {
+        const auto* phase = report.find(curr_budget.phase);
+        if (phase == nullptr) {
+            continue;
+        }
+        
+        auto units = curr_budget.unit == BudgetUnit::token ? tokens :
+                     curr_budget.unit == BudgetUnit::instruction ? instructions : 0;
+        billiec::AllocationCounts counts{phase->allocations, phase->bytes, 0};
+        if (billiec::within_allocation_budget(counts, curr_budget.max_per_unit, units, curr_budget.allowance)) {
+            continue;
+        }
+        
+        exceeded << " " << curr_budget.phase << " made " << phase->allocations << " allocations";
+        if (units != 0) {
+            exceeded << " for " << units << (curr_budget.unit == BudgetUnit::token ? " tokens" : " instructions");
+        }
+        exceeded << ".";
+    }
     
-    billiec::scanner::TokenScanner scanner{file_source};
-    auto tokens = scanner.get_tokens();
+    if (exceeded.tellp() != 0) {
+        billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::allocation_budget_exceeded),
+                              "Allocation budget exceeded:"};
+        ec << exceeded.str();
+        throw billiec::RuntimeError(std::move(ec));
+    }
+}
+
+// Anything not going to the output file goes to out, so batch mode can keep each file's text together.
+void compile_source(const billiec::RuntimeConfig& cfg, const std::string& file_source, std::ostream& out,
+                    billiec::TimeReport& report) {
+    billiec::TraceSpan span{"compile", cfg.input_file.empty() ? std::string_view{"<source>"} : cfg.input_file};
     
-    billiec::parser::LanguageParser parser{tokens};
-    auto program_node = parser.parse_program();
+    // Pass stats need the passes to run, so asking for them goes around the cache.
+    std::optional<billiec::CompileCache> cache;
+    std::string cache_key;
+    auto cached_output = [&](const std::string& key_source) {
+        auto assembly = report.measure("cache lookup", [&] {
+            cache.emplace(cfg.cache_dir, cfg.cache_max_size);
+            cache_key = cache->key(key_source, cache_options(cfg));
+            return cache->lookup(cache_key);
+        });
+        if (assembly) {
+            report.measure("write", [&] { write_output(cfg, out, *assembly); });
+        }
+        return assembly.has_value();
+    };
+    bool use_cache = !cfg.cache_dir.empty() && !wants_pass_stats(cfg);
+    bool preprocessing = needs_preprocessing(cfg, file_source);
     
-    auto tacky_generator = billiec::codegen::TackyGenerator{std::move(program_node)};
-    auto tacky_node = tacky_generator.generate_tacky();
+    // Without includes the source alone decides the output, and the cache can answer before lexing.
+    if (use_cache && !preprocessing && cached_output(file_source)) {
+        return;
+    }
     
-    auto assembly_generator = billiec::codegen::AssemblyGenerator{std::move(tacky_node)};
-    auto instructions = assembly_generator.generate_assembly();
+    auto tokens = report.measure("lex", [&] { return scan_source(cfg, file_source, out); });
     
-    auto pseudo_register_pass = billiec::codegen::AssemblerPassPseudoRegister{std::move(instructions)};
-    auto stack_offset = pseudo_register_pass.process();
+    // With them the key has to be what the headers expanded to, an edited header is a different compile.
+    if (preprocessing) {
+        tokens = report.measure("preprocess", [&] { return preprocess(cfg, tokens); });
+        if (use_cache) {
+            std::string expanded;
+            for(const auto& curr_token: tokens) {
+                expanded += curr_token.lexeme;
+                expanded += '\n';
+            }
+            if (cached_output(expanded)) {
+                return;
+            }
+        }
+    }
     
-    auto fix_instructions_pass = billiec::codegen::AssemblerPassFixInstructions{std::move(pseudo_register_pass.instructions), stack_offset};
-    fix_instructions_pass.process();
+    auto program_node = report.measure("parse", [&] { return parse_tokens(cfg, tokens, file_source, out); });
     
-    if (!cfg.output_file.empty()) {
-        std::ofstream stream{cfg.output_file};
-        //assembler_node->emit(stream);
-        auto emit = billiec::codegen::AssemblerPassEmit(fix_instructions_pass.instructions, stream);
-        emit.process();
-        
-        stream.flush();
-        stream.close();
-    } else {
-        auto emit = billiec::codegen::AssemblerPassEmit(fix_instructions_pass.instructions, std::cout);
-        emit.process();
+    const auto& optimization_level = *billiec::codegen::find_optimization_level(cfg.optimization_level);
+    const auto& machine_model = *billiec::codegen::find_machine_model(cfg.mcpu);
+    auto lowered = billiec::billie::lower_program(std::move(program_node), optimization_level, machine_model,
+                                                  [&](const char* phase, const std::function<void()>& run) {
+                                                      report.measure(phase, run);
+                                                  });
+    
+    report.measure("emit", [&] {
+        if (cache) {
+            // Cached output has to come out the same for every hit.
+            std::ostringstream stream;
+            auto emit = billiec::codegen::AssemblerPassEmit(lowered.program, stream);
+            emit.emit_timestamp = false;
+            emit.process();
+            
+            auto assembly = std::move(stream).str();
+            write_output(cfg, out, assembly);
+            cache->store(cache_key, assembly);
+        } else if (!cfg.output_file.empty()) {
+            std::ofstream stream{cfg.output_file};
+            //assembler_node->emit(stream);
+            auto emit = billiec::codegen::AssemblerPassEmit(lowered.program, stream);
+            emit.emit_timestamp = !cfg.deterministic_output;
+            emit.process();
+            
+            stream.flush();
+            stream.close();
+        } else {
+            auto emit = billiec::codegen::AssemblerPassEmit(lowered.program, out);
+            emit.emit_timestamp = !cfg.deterministic_output;
+            emit.process();
+        }
+    });
+    
+    if (cfg.check_allocation_budgets) {
+        check_allocation_budgets(report, tokens.size(), lowered.instruction_count);
+    }
+    
+    if (cfg.print_value_numbering_stats) {
+        out << "value numbering"
+            << ": redundant=" << lowered.redundant_values
+            << " folded=" << lowered.folded_values << "\n";
+    }
+    
+    if (cfg.print_regalloc_stats) {
+        for(const auto& [func_name, func_stats]: lowered.register_allocation_stats) {
+            out << "regalloc " << func_name
+                << ": intervals=" << func_stats.intervals
+                << " spills=" << func_stats.spills
+                << " rematerialized=" << func_stats.rematerialized
+                << " callee_saved=" << func_stats.callee_saved_used << "\n";
+        }
+    }
+    
+    if (cfg.print_peephole_stats) {
+        for(const auto& [rule_name, hits]: lowered.peephole_stats) {
+            out << "peephole " << rule_name << ": " << hits << "\n";
+        }
+    }
+    
+    if (cfg.print_schedule_stats) {
+        for(const auto& [func_name, func_stats]: lowered.schedule_stats) {
+            out << "schedule " << func_name << " (" << machine_model.name << ")"
+                << ": instructions=" << func_stats.instructions
+                << " cycles_before=" << func_stats.cycles_before
+                << " cycles_after=" << func_stats.cycles_after << "\n";
+        }
     }
 }
 
-billiec::RuntimeConfig process_command_line(int argc, char* argv[]) {
+void print_time_report(const billiec::RuntimeConfig& cfg, const billiec::TimeReport& report, std::ostream& out) {
+    if (cfg.time_report == billiec::TimeReportFormat::json) {
+        report.print_json(out, cfg.input_file);
+    } else if (cfg.time_report == billiec::TimeReportFormat::text) {
+        report.print_text(out, cfg.input_file);
+    }
+}
+
+void run_codegen(const billiec::RuntimeConfig& cfg, std::ostream& out) {
+    billiec::TimeReport report{cfg.time_report != billiec::TimeReportFormat::none || cfg.check_allocation_budgets};
+    auto file_source = report.measure("read", [&] { return read_file(cfg.input_file); });
+    compile_source(cfg, file_source, out, report);
+    print_time_report(cfg, report, out);
+}
+
+/** @brief  Compiles every input on a work-stealing pool, returns how many failed.
+ *
+ * Each file's diagnostics and stats are buffered and written out in one piece once it finishes,
+ * so the output of files compiled side by side never interleaves.
+ */
+std::size_t run_batch(const billiec::RuntimeConfig& cfg) {
+    std::mutex output_mutex;
+    std::size_t failures = 0;
+    
+    {
+        billiec::WorkStealingPool pool{cfg.jobs};
+        for(const auto& curr_input: cfg.input_files) {
+            pool.submit([&cfg, &curr_input, &output_mutex, &failures] {
+                auto file_cfg = cfg;
+                file_cfg.input_file = curr_input;
+                file_cfg.output_file = std::filesystem::path{curr_input}.replace_extension(".s").string();
+                
+                std::ostringstream log;
+                bool failed = false;
+                try {
+                    run_codegen(file_cfg, log);
+                } catch (const std::exception& exc) {
+                    log << curr_input << ": Caught: " << exc.what() << "\n";
+                    failed = true;
+                }
+                
+                auto text = std::move(log).str();
+                std::lock_guard lock{output_mutex};
+                std::cout << text;
+                failures += failed ? 1 : 0;
+            });
+        }
+    }
+    
+    std::cout << "batch: " << cfg.input_files.size() << " files, " << failures << " failed\n";
+    return failures;
+}
+
+std::uint64_t parse_size(std::string_view text) {
+    std::uint64_t size = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), size);
+    std::string_view suffix{end, text.data() + text.size()};
+    int shift = suffix == "k" || suffix == "K" ? 10 :
+                suffix == "m" || suffix == "M" ? 20 :
+                suffix == "g" || suffix == "G" ? 30 : 0;
+    if (ec != std::errc{} || end == text.data() || (shift == 0 && !suffix.empty())) {
+        billiec::ErrorCode error{billiec::make_error_code(billiec::errc::invalid_cache_size),
+                                 "Not a size for --cache-max-size: "};
+        error << text;
+        throw billiec::RuntimeError(std::move(error));
+    }
+    return size << shift;
+}
+
+// Relative paths in a forwarded command line are relative to where the client ran.
+void resolve_path(std::string& path, const std::filesystem::path& working_directory) {
+    if (!path.empty() && std::filesystem::path{path}.is_relative()) {
+        path = (working_directory / path).string();
+    }
+}
+
+// One file name per line, blank lines are skipped.
+void add_response_file(billiec::RuntimeConfig& config, std::string response_file,
+                       const std::filesystem::path& working_directory) {
+    resolve_path(response_file, working_directory);
+    std::ifstream stream{response_file};
+    if (!stream) {
+        billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::response_file_unreadable),
+                              "Can't read response file: "};
+        ec << response_file;
+        throw billiec::RuntimeError(std::move(ec));
+    }
+    
+    std::string line;
+    while(std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            config.input_file = line;
+            config.input_files.push_back(line);
+        }
+    }
+}
+
+// Never exits, so the server can parse what its clients send.  Response files are read from
+// working_directory, the current directory when it's empty.
+billiec::RuntimeConfig parse_command_line(int argc, char* argv[], const std::filesystem::path& working_directory = {}) {
     billiec::RuntimeConfig config;
     
     for(int i = 1; i < argc; ++i) {
         if (std::strcmp(argv[i], "--help") == 0) {
-            print_help();
-            exit(0);
+            config.show_help = true;
         } else if (std::strcmp(argv[i], "--lex") == 0) {
             config.run_stage = billiec::RunStage::stage_lexer;
         } else if (std::strcmp(argv[i], "--parse") == 0) {
             config.run_stage = billiec::RunStage::stage_parser;
         } else if (std::strcmp(argv[i], "--codegen") == 0) {
             config.run_stage = billiec::RunStage::stage_code_gen;
+        } else if (std::strcmp(argv[i], "--regalloc-stats") == 0) {
+            config.print_regalloc_stats = true;
+        } else if (std::strcmp(argv[i], "--value-numbering-stats") == 0) {
+            config.print_value_numbering_stats = true;
+        } else if (std::strcmp(argv[i], "--peephole-stats") == 0) {
+            config.print_peephole_stats = true;
+        } else if (std::strcmp(argv[i], "--schedule-stats") == 0) {
+            config.print_schedule_stats = true;
+        } else if (std::strncmp(argv[i], "-mcpu=", 6) == 0) {
+            config.mcpu = argv[i] + 6;
+            if (billiec::codegen::find_machine_model(config.mcpu) == nullptr) {
+                billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::unknown_mcpu),
+                                      "Unknown cpu for -mcpu: "};
+                ec << config.mcpu;
+                throw billiec::RuntimeError(std::move(ec));
+            }
+        } else if (std::strncmp(argv[i], "-O", 2) == 0) {
+            config.optimization_level = argv[i] + 2;
+            if (billiec::codegen::find_optimization_level(config.optimization_level) == nullptr) {
+                billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::unknown_optimization_level),
+                                      "Unknown optimization level: "};
+                ec << argv[i];
+                throw billiec::RuntimeError(std::move(ec));
+            }
+        } else if (std::strcmp(argv[i], "--time-report") == 0 ||
+                   std::strcmp(argv[i], "--time-report=text") == 0) {
+            config.time_report = billiec::TimeReportFormat::text;
+        } else if (std::strcmp(argv[i], "--time-report=json") == 0) {
+            config.time_report = billiec::TimeReportFormat::json;
+        } else if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            config.trace_file = argv[i] + 8;
+        } else if (std::strcmp(argv[i], "--check-allocation-budgets") == 0) {
+            if (!billiec::allocation_tracking_enabled) {
+                billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::allocation_tracking_disabled),
+                                      "--check-allocation-budgets needs a build with -DBILLIE_TRACK_ALLOCATIONS=ON."};
+                throw billiec::RuntimeError(std::move(ec));
+            }
+            config.check_allocation_budgets = true;
+        } else if (std::strcmp(argv[i], "--deterministic") == 0) {
+            config.deterministic_output = true;
+        } else if (std::strncmp(argv[i], "--cache-dir=", 12) == 0) {
+            config.cache_dir = argv[i] + 12;
+        } else if (std::strncmp(argv[i], "--cache-max-size=", 17) == 0) {
+            config.cache_max_size = parse_size(argv[i] + 17);
+        } else if (std::strcmp(argv[i], "--cache-stats") == 0) {
+            config.print_cache_stats = true;
         } else if (std::strcmp(argv[i], "--output") == 0) {
             if (i+1 >= argc) {
                 auto ec =  billiec::ErrorCode{billiec::make_error_code(billiec::errc::output_file_missing),
                                               "You specified --output but no file was given."};
                 throw billiec::RuntimeError(std::move(ec));
             }
-            config.output_file = argv[i+1];
+            config.output_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--batch") == 0) {
+            config.batch_mode = true;
+        } else if (std::strncmp(argv[i], "--serve=", 8) == 0) {
+            config.serve_socket = argv[i] + 8;
+        } else if (std::strncmp(argv[i], "--connect=", 10) == 0) {
+            config.connect_socket = argv[i] + 10;
+        } else if (std::strncmp(argv[i], "--jobs=", 7) == 0) {
+            config.jobs = std::strtoul(argv[i] + 7, nullptr, 10);
+        } else if (std::strncmp(argv[i], "--emit-pch=", 11) == 0) {
+            config.emit_pch = argv[i] + 11;
+        } else if (std::strncmp(argv[i], "--include-pch=", 14) == 0) {
+            config.include_pch = argv[i] + 14;
+        } else if (std::strncmp(argv[i], "-I", 2) == 0) {
+            config.include_directories.push_back(argv[i] + 2);
+        } else if (std::strncmp(argv[i], "-D", 2) == 0) {
+            std::string_view definition{argv[i] + 2};
+            auto equals = definition.find('=');
+            if (equals == std::string_view::npos) {
+                config.defines.emplace_back(definition, "1");
+            } else {
+                config.defines.emplace_back(definition.substr(0, equals), definition.substr(equals + 1));
+            }
+        } else if (argv[i][0] == '@') {
+            add_response_file(config, argv[i] + 1, working_directory);
         } else if (std::strncmp(argv[i], "--", 2) == 0) {
             billiec::ErrorCode ec{billiec::make_error_code(billiec::errc::unknown_cmdline_option),
                                   "Unknown option: "};
@@ -130,35 +643,164 @@ billiec::RuntimeConfig process_command_line(int argc, char* argv[]) {
             throw billiec::RuntimeError(std::move(ec)); 
         } else {
             config.input_file = argv[i];
+            config.input_files.push_back(config.input_file);
         }
     }
     
     return config;
 }
 
+billiec::RuntimeConfig process_command_line(int argc, char* argv[]) {
+    auto config = parse_command_line(argc, argv);
+    if (config.show_help) {
+        print_help();
+        exit(0);
+    }
+    return config;
+}
+
 void validate_config(const billiec::RuntimeConfig& cfg) {
     if (cfg.input_file.empty()) {
         throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::file_not_specified),
                                     "No file was specified."}};
     }
+    if (cfg.batch_mode && !cfg.output_file.empty()) {
+        throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::batch_with_output),
+                                    "--batch writes each output next to its input, --output can't be used with it."}};
+    }
+}
+
+int handle_request(const billiec::CompileRequest& request, std::ostream& out) {
+    std::vector<std::string> arguments{"billie"};
+    arguments.insert(arguments.end(), request.arguments.begin(), request.arguments.end());
+    std::vector<char*> argv;
+    for(auto& curr_argument: arguments) {
+        argv.push_back(curr_argument.data());
+    }
+    
+    auto cfg = parse_command_line(static_cast<int>(argv.size()), argv.data(), request.working_directory);
+    if (cfg.show_help) {
+        throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::unsupported_server_request),
+                                    "Run billie --help without --connect for help."}};
+    }
+    if (cfg.run_stage != billiec::RunStage::stage_code_gen || cfg.batch_mode || !cfg.emit_pch.empty() ||
+        !cfg.serve_socket.empty() || !cfg.connect_socket.empty()) {
+        throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::unsupported_server_request),
+                                    "The server only runs --codegen for a single file."}};
+    }
+    if (!cfg.trace_file.empty()) {
+        throw billiec::RuntimeError{billiec::ErrorCode{billiec::make_error_code(billiec::errc::unsupported_server_request),
+                                    "Start the server with --trace to trace the compiles it runs."}};
+    }
+    
+    resolve_path(cfg.output_file, request.working_directory);
+    resolve_path(cfg.cache_dir, request.working_directory);
+    resolve_path(cfg.include_pch, request.working_directory);
+    for(auto& curr_directory: cfg.include_directories) {
+        resolve_path(curr_directory, request.working_directory);
+    }
+    // A source sent over the socket still looks for its quoted includes where the client is.
+    resolve_path(cfg.input_file, request.working_directory);
+    if (request.source) {
+        billiec::TimeReport report{cfg.time_report != billiec::TimeReportFormat::none || cfg.check_allocation_budgets};
+        compile_source(cfg, *request.source, out, report);
+        print_time_report(cfg, report, out);
+    } else {
+        validate_config(cfg);
+        run_codegen(cfg, out);
+    }
+    return 0;
+}
+
+void run_server(const billiec::RuntimeConfig& cfg) {
+    billiec::CompileServer server{cfg.serve_socket, handle_request, cfg.jobs};
+    std::cout << "serving on " << cfg.serve_socket << "\n" << std::flush;
+    server.run();
+}
+
+// Everything past the program name but --connect and --trace goes to the server as it was given.
+int run_client(const billiec::RuntimeConfig& cfg, int argc, char* argv[]) {
+    billiec::CompileRequest request;
+    request.working_directory = std::filesystem::current_path().string();
+    for(int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--connect=", 10) != 0 && std::strncmp(argv[i], "--trace=", 8) != 0) {
+            request.arguments.push_back(argv[i]);
+        }
+    }
+    if (cfg.input_file == "-") {
+        request.source.emplace(std::istreambuf_iterator<char>{std::cin}, std::istreambuf_iterator<char>{});
+    }
     
-    return billiec::ErrorCode{};
+    billiec::TraceSpan span{"request", cfg.input_file};
+    return billiec::forward_to_server(cfg.connect_socket, request, std::cout);
 }
 
+/** @brief  Starts tracing when a trace file was asked for, and writes it out however main leaves. */
+class TraceFile {
+public:
+    explicit TraceFile(std::string path):
+        path_{std::move(path)} {
+        if (!path_.empty()) {
+            billiec::Tracer::start();
+        }
+    }
+    
+    ~TraceFile() {
+        if (!path_.empty()) {
+            std::ofstream stream{path_};
+            billiec::Tracer::write_json(stream);
+        }
+    }
+    
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+    
+private:
+    std::string path_;
+};
 
 int main(int argc, char* argv[]) {
     print_banner();
     
     try {
         auto cfg = process_command_line(argc, argv);
+        TraceFile trace_file{cfg.trace_file};
+        if (!cfg.serve_socket.empty()) {
+            run_server(cfg);
+            return 0;
+        }
+        if (!cfg.connect_socket.empty()) {
+            return run_client(cfg, argc, argv);
+        }
+        if (cfg.print_cache_stats && cfg.input_file.empty() && !cfg.cache_dir.empty()) {
+            print_cache_stats(cfg);
+            return 0;
+        }
         validate_config(cfg);
         
+        if (!cfg.emit_pch.empty()) {
+            run_emit_pch(cfg);
+            return 0;
+        }
+        
+        if (cfg.batch_mode) {
+            auto failures = run_batch(cfg);
+            if (cfg.print_cache_stats && !cfg.cache_dir.empty()) {
+                print_cache_stats(cfg);
+            }
+            return failures == 0 ? 0 : 44;
+        }
+        
         if (cfg.run_stage == billiec::RunStage::stage_lexer) {
             run_lexer(cfg);
         } else if (cfg.run_stage == billiec::RunStage::stage_parser) {
             run_parser(cfg);
         } else if (cfg.run_stage == billiec::RunStage::stage_code_gen) {
-            run_codegen(cfg);
+            run_codegen(cfg, std::cout);
+        }
+        
+        if (cfg.print_cache_stats && !cfg.cache_dir.empty()) {
+            print_cache_stats(cfg);
         }
     } catch (const std::exception& exc) {
         std::cout << "Caught: " << exc.what() << "\n";
@@ -0,0 +1,127 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+
+// Checks signed_division_magic against C division, replaying the smull sequence the instruction
+// selector emits for it.  Every divisor in [-2^20, 2^20] is checked, then divisors around every
+// power of two and the ends of the range, then random ones, each with the dividends where
+// rounding goes wrong first: either side of the multiples nearest both ends of int and of zero.
+
+#include <codegen/InstructionSelector.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+using billiec::codegen::DivisionMagic;
+using billiec::codegen::signed_division_magic;
+
+constexpr int int_min = std::numeric_limits<int>::min();
+constexpr int int_max = std::numeric_limits<int>::max();
+
+constexpr int sampled_range = 1 << 20;
+constexpr int random_divisors = 200'000;
+
+int wrap(std::int64_t value) {
+    return static_cast<int>(static_cast<std::uint32_t>(value));
+}
+
+// smull, then the add or sub of the dividend when the multiplier's sign needs it, the shifts,
+// and the sign bit added to round toward zero.
+int magic_quotient(int dividend, int divisor, const DivisionMagic& magic) {
+    auto product = static_cast<std::int64_t>(dividend) * magic.multiplier;
+    int shifted = 0;
+    if (divisor > 0 && magic.multiplier < 0) {
+        shifted = wrap(static_cast<std::int64_t>(wrap(product >> 32)) + dividend) >> magic.shift;
+    } else if (divisor < 0 && magic.multiplier > 0) {
+        shifted = wrap(static_cast<std::int64_t>(wrap(product >> 32)) - dividend) >> magic.shift;
+    } else {
+        shifted = wrap(product >> (32 + magic.shift));
+    }
+    return wrap(static_cast<std::int64_t>(shifted) + (static_cast<std::uint32_t>(shifted) >> 31));
+}
+
+void add_around(std::vector<int>& dividends, std::int64_t center) {
+    for(std::int64_t curr = center - 1; curr <= center + 1; ++curr) {
+        if (curr >= int_min && curr <= int_max) {
+            dividends.push_back(static_cast<int>(curr));
+        }
+    }
+}
+
+std::vector<int> dividends_for(int divisor) {
+    std::vector<int> dividends = {int_min, int_min + 1, int_max - 1, int_max, -1, 0, 1};
+    std::int64_t magnitude = divisor < 0 ? -static_cast<std::int64_t>(divisor) : divisor;
+    std::int64_t top = int_max / magnitude * magnitude;
+    std::int64_t bottom = -(-static_cast<std::int64_t>(int_min) / magnitude * magnitude);
+    for(std::int64_t curr: {top, top - magnitude, bottom, bottom + magnitude, magnitude, -magnitude, 2 * magnitude, -2 * magnitude}) {
+        add_around(dividends, curr);
+    }
+    return dividends;
+}
+
+// The number of wrong quotients, the first few of them printed.
+std::size_t check_divisor(int divisor, std::size_t& checked) {
+    auto magic = signed_division_magic(divisor);
+    std::size_t failures = 0;
+    for(int curr_dividend: dividends_for(divisor)) {
+        ++checked;
+        // INT_MIN / -1 is undefined, and -1 never gets a magic number anyway.
+        int expected = curr_dividend / divisor;
+        int actual = magic_quotient(curr_dividend, divisor, magic);
+        if (actual != expected) {
+            if (failures++ < 4) {
+                std::cout << "division by " << divisor << " of " << curr_dividend << ": got " << actual
+                          << ", expected " << expected << " (multiplier " << magic.multiplier
+                          << ", shift " << magic.shift << ")\n";
+            }
+        }
+    }
+    return failures;
+}
+
+// Everything but 0, 1, -1 and INT_MIN, which division never asks a magic number for.
+bool has_magic(std::int64_t divisor) {
+    return divisor >= int_min + 1 && divisor <= int_max && divisor != 0 && divisor != 1 && divisor != -1;
+}
+
+} // namespace
+
+int main() {
+    std::vector<int> divisors;
+    for(int curr = -sampled_range; curr <= sampled_range; ++curr) {
+        if (has_magic(curr)) {
+            divisors.push_back(curr);
+        }
+    }
+    for(int power = 1; power < 32; ++power) {
+        auto two_power = std::int64_t{1} << power;
+        for(std::int64_t delta = -3; delta <= 3; ++delta) {
+            for(auto curr: {two_power + delta, -two_power + delta}) {
+                if (has_magic(curr)) {
+                    divisors.push_back(static_cast<int>(curr));
+                }
+            }
+        }
+    }
+    
+    std::mt19937 generator{20250101};
+    std::uniform_int_distribution<int> any_int{int_min + 1, int_max};
+    while(divisors.size() < 2 * static_cast<std::size_t>(sampled_range) + random_divisors) {
+        auto curr = any_int(generator);
+        if (has_magic(curr)) {
+            divisors.push_back(curr);
+        }
+    }
+    
+    std::size_t checked = 0;
+    std::size_t failures = 0;
+    for(int curr_divisor: divisors) {
+        failures += check_divisor(curr_divisor, checked);
+    }
+    
+    std::cout << divisors.size() << " divisors, " << checked << " quotients, " << failures << " wrong\n";
+    return failures == 0 ? 0 : 1;
+}
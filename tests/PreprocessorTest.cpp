@@ -0,0 +1,79 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+
+// Checks what macro expansion leaves for sources where the replacement has to be rescanned
+// together with the tokens after it, the alias of a function-like macro first among them.
+
+#include <scanner/Preprocessor.h>
+#include <scanner/SourceFileCache.h>
+#include <scanner/TokenScanner.h>
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct ExpansionCase {
+    const char* name;
+    const char* source;
+    const char* expected;      ///< The lexemes left, one space apart.
+};
+
+constexpr ExpansionCase expansion_cases[] = {
+    {"alias of a function-like macro",
+     "#define G(x) (x + 1)\n#define F G\nreturn F(41);\n",
+     "return ( 41 + 1 ) ;"},
+    {"alias with its arguments on the next line",
+     "#define G(x) (x + 1)\n#define F G\nreturn F\n(41);\n",
+     "return ( 41 + 1 ) ;"},
+    {"alias of an alias",
+     "#define G(x) (x + 1)\n#define F G\n#define E F\nreturn E(41);\n",
+     "return ( 41 + 1 ) ;"},
+    {"function-like macro expanding to a function-like name",
+     "#define G(x) (x + 1)\n#define H() G\nreturn H()(41);\n",
+     "return ( 41 + 1 ) ;"},
+    {"alias without arguments",
+     "#define G(x) (x + 1)\n#define F G\nreturn F;\n",
+     "return G ;"},
+    {"alias as an argument",
+     "#define G(x) (x + 1)\n#define F G\nreturn F(F);\n",
+     "return ( G + 1 ) ;"},
+    {"empty expansion between a name and its parenthesis",
+     "#define G(x) (x + 1)\n#define E\nreturn G E (41);\n",
+     "return G ( 41 ) ;"},
+    {"macro ending in its own name",
+     "#define R(x) x R\nreturn R(1)(2);\n",
+     "return 1 R ( 2 ) ;"},
+};
+
+std::string expand(const char* source) {
+    billiec::scanner::SourceFileCache file_cache;
+    billiec::scanner::Preprocessor preprocessor{file_cache};
+    auto tokens = preprocessor.preprocess(billiec::scanner::TokenScanner{source}.get_tokens(), "test.c");
+
+    std::string text;
+    for(const auto& curr_token: tokens) {
+        if (curr_token.lexeme.empty()) {
+            continue;
+        }
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += curr_token.lexeme;
+    }
+    return text;
+}
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    for(const auto& curr_case: expansion_cases) {
+        auto actual = expand(curr_case.source);
+        if (actual != curr_case.expected) {
+            std::cout << curr_case.name << ": got '" << actual << "', expected '" << curr_case.expected << "'\n";
+            ++failures;
+        }
+    }
+    std::cout << std::size(expansion_cases) - failures << " of " << std::size(expansion_cases) << " expansions right\n";
+    return failures == 0 ? 0 : 1;
+}
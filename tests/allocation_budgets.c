@@ -0,0 +1,31 @@
+// Copyright 2025 Yasser Zabuair.  See LICENSE for details.
+
+// Nested deep enough to spill at -O0, the fixed input the allocation budgets are checked on.
+int main(void) {
+    return
+        ((3439 / 5) + ((425 / 4) - ((6482 / 1) * ((5835 / 3) + ((4817 / 2) * ((142 / 2) + ((5699 / 7) +
+        ((6417 / 9) - ((4912 / 5) + ((7540 / 7) * ((9466 / 6) - ((9 / 1) - ((7881 / 7) * ((4632 / 7) *
+        ((7845 / 3) - ((7073 / 2) - ((4878 / 5) - ((1625 / 7) + ((8405 / 2) + ((555 / 1) + ((70 / 7) -
+        ((9102 / 4) + ((8876 / 8) - ((8465 / 4) - ((2148 / 9) + ((8010 / 6) - ((4607 / 4) - ((3104 / 3)
+        - ((2814 / 6) * ((4681 / 3) + ((1987 / 4) - ((1036 / 4) + ((1696 / 2) + ((7521 / 9) + ((5838 /
+        5) - ((2054 / 6) - ((4841 / 9) + ((1420 / 8) + ((4740 / 1) - ((1583 / 3) - ((6239 / 3) + ((2056
+        / 6) - ((3475 / 8) - ((5381 / 6) - ((7334 / 6) + ((7849 / 4) + ((5574 / 1) - ((6352 / 9) -
+        ((1256 / 5) - ((45 / 9) - ((5801 / 1) * ((6765 / 4) + ((9234 / 8) - ((979 / 3) - ((658 / 5) *
+        ((9236 / 2) + ((9242 / 1) + ((2134 / 6) - ((5028 / 6) + ((4922 / 5) - ((7895 / 2) - ((591 / 2) *
+        ((3313 / 9) - ((3765 / 3) * ((6206 / 1) - ((267 / 1) - ((4794 / 8) - ((6086 / 3) + ((2253 / 6) *
+        ((3421 / 8) * ((5638 / 2) + ((9344 / 5) + ((170 / 7) + ((6096 / 7) + ((7889 / 8) - ((8009 / 7) +
+        ((2343 / 9) - ((5757 / 9) + ((9324 / 6) * ((9248 / 4) + ((9291 / 6) * ((8892 / 2) + ((2789 / 9)
+        * ((3206 / 8) - ((7677 / 8) + ((2367 / 7) + ((206 / 2) + ((3172 / 6) * ((7789 / 8) - ((1906 / 7)
+        + ((1631 / 9) - ((6604 / 5) * ((9899 / 6) + ((1071 / 4) * ((1173 / 3) + ((2562 / 9) - ((654 / 6)
+        - ((4224 / 9) * ((9906 / 1) - ((1846 / 5) - ((8076 / 4) - ((716 / 8) - ((7105 / 1) + ((4838 / 8)
+        + ((1638 / 7) * ((880 / 5) + ((2678 / 5) - ((9833 / 6) + ((8118 / 1) + ((805 / 9) + ((7282 / 9)
+        - ((5116 / 5) + ((3739 / 1) * ((5800 / 5) * ((9343 / 9) + ((8233 / 7) * ((6044 / 6) - ((6974 /
+        3) - ((7002 / 1) - ((4161 / 6) + ((1342 / 4) - ((1494 / 1) + ((8833 / 7) - ((9689 / 5) * ((1623
+        / 9) * ((8800 / 4) + ((4382 / 9) + ((1896 / 2) - ((3516 / 7) + ((3589 / 5) - ((4070 / 8) -
+        ((5138 / 4) + ((8359 / 2) * ((2725 / 8) + ((4663 / 6) + ((8582 / 2) + ((9037 / 1) + ((6840 / 5)
+        - ((7924 / 7) + ((5891 / 6) - ((4598 / 5) + ((7307 / 1) - ((5092 / 4) + ((4215 / 4) * ((9055 /
+        4) * ((3736 / 4) * ((2546 / 5) - ((8861 / 2) + ((7780 / 9) * ((7528 / 1) - ((1786 / 9) * ((7663
+        / 9) + ((3867 / 7) - ((8476 / 2) - ((6012 / 9) - ((3539 / 4) + ((6308 / 1) * ((779 / 5) - ((7472
+        / 3) + ((8760 / 6) +
+        7))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))));
+}
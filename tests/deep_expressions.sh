@@ -0,0 +1,34 @@
+#!/bin/sh
+# Compiles an expression nested a million levels deep with 1 MB of native stack, every walk over
+# it has to keep its own stack on the heap.
+#
+# usage: deep_expressions.sh <billie> <work dir> right_nested|left_nested|unary|right_division|left_division
+
+set -e
+
+billie=$1
+work_dir=$2
+shape=$3
+depth=1000000
+stack_kb=1024
+
+case "$shape" in
+    right_nested)   prefix="(1 + "; middle="1";    suffix=")" ;;
+    left_nested)    prefix="(";     middle="1";    suffix=" + 1)" ;;
+    unary)          prefix="-~";    middle="5";    suffix="" ;;
+    right_division) prefix="(7 / "; middle="7";    suffix=")" ;;
+    left_division)  prefix="(";     middle="1000"; suffix=" / 1)" ;;
+    *)              echo "unknown shape: $shape"; exit 1 ;;
+esac
+
+mkdir -p "$work_dir"
+awk -v depth="$depth" -v prefix="$prefix" -v middle="$middle" -v suffix="$suffix" 'BEGIN {
+    printf "int main(void) {\n    return "
+    for(i = 0; i < depth; ++i) printf "%s", prefix
+    printf "%s", middle
+    for(i = 0; i < depth; ++i) printf "%s", suffix
+    printf ";\n}\n"
+}' > "$work_dir/$shape.c"
+
+(ulimit -s "$stack_kb" && exec "$billie" --codegen "$work_dir/$shape.c" --output "$work_dir/$shape.s") > /dev/null
+grep -q "^ret$" "$work_dir/$shape.s"